@@ -21,11 +21,11 @@ typedef struct {
     float x, x_dot, theta, theta_dot;
 } CartPoleState;
 
-void cartpole_reset(CartPoleState* state) {
-    state->x = ((rand() % 200) - 100) / 1000.0;
-    state->x_dot = ((rand() % 200) - 100) / 1000.0;
-    state->theta = ((rand() % 200) - 100) / 1000.0;
-    state->theta_dot = ((rand() % 200) - 100) / 1000.0;
+void cartpole_reset(CartPoleState* state, Rng* rng) {
+    state->x = (rng_int(rng, 200) - 100) / 1000.0;
+    state->x_dot = (rng_int(rng, 200) - 100) / 1000.0;
+    state->theta = (rng_int(rng, 200) - 100) / 1000.0;
+    state->theta_dot = (rng_int(rng, 200) - 100) / 1000.0;
 }
 
 int cartpole_is_done(CartPoleState* state) {
@@ -62,7 +62,7 @@ void analyze_controller(Program* prog, int num_trials) {
 
     for (int trial = 0; trial < num_trials; trial++) {
         CartPoleState state;
-        cartpole_reset(&state);
+        cartpole_reset(&state, gp_rng());
 
         int steps = 0;
         for (; steps < 500; steps++) {
@@ -99,7 +99,7 @@ void analyze_controller(Program* prog, int num_trials) {
     printf("---------------------------------------------------------------\n");
 
     CartPoleState state;
-    cartpole_reset(&state);
+    cartpole_reset(&state, gp_rng());
 
     for (int i = 0; i < 10; i++) {
         Context ctx = {0};
@@ -142,7 +142,7 @@ int main() {
     output->children[0] = add;
     output->num_children = 1;
 
-    Program* pd_controller = malloc(sizeof(Program));
+    Program* pd_controller = calloc(1, sizeof(Program));
     pd_controller->root = output;
     pd_controller->fitness = 0;
     prog_update_metadata(pd_controller);
@@ -169,7 +169,7 @@ int main() {
     output2->children[0] = add2;
     output2->num_children = 1;
 
-    Program* pdx_controller = malloc(sizeof(Program));
+    Program* pdx_controller = calloc(1, sizeof(Program));
     pdx_controller->root = output2;
     pdx_controller->fitness = 0;
     prog_update_metadata(pdx_controller);
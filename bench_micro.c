@@ -0,0 +1,378 @@
+#include "gp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+// Microbenchmarks for the GP kernels. Every run builds the same corpus from
+// the seed (a short cartpole run), then times each kernel in samples of a
+// calibrated number of operations and reports ns/op percentiles over the
+// samples and node allocations per op. --json prints one JSON object per
+// benchmark, for tracking regressions across releases. --perf adds hardware
+// counters per op and per executed node where the machine allows them.
+
+// Task fitness functions, linked in from the test programs (see Makefile)
+float evaluate_add(Program* prog, void* data, Rng* rng);
+float evaluate_add_adf(Program* prog, void* data, Rng* rng);
+float evaluate_cartpole(Program* prog, void* data, Rng* rng);
+float evaluate_maze(Program* prog, void* data, Rng* rng);
+float evaluate_mux(Program* prog, void* data, Rng* rng);
+float evaluate_parity(Program* prog, void* data, Rng* rng);
+float evaluate_sequence(Program* prog, void* data, Rng* rng);
+float evaluate_taxi(Program* prog, void* data, Rng* rng);
+
+#define CORPUS_GENERATIONS 5
+#define SAMPLE_NS 2000000.0     // Target length of one sample
+#define MIN_BATCH 16            // Operations per sample, at least
+
+typedef struct {
+    Population* pop;
+    Program** progs;            // Scored, ranked programs of the last generation
+    int size;
+    Context* contexts;          // Fixed inputs, one per program
+    LinearTree** linear;        // Linear genome of each program
+    uint64_t seed;
+    FitnessFn fitness;          // For the fitness benchmarks
+    PerfCounters* perf;         // --perf (NULL = off)
+    LibraryEntry library[MAX_LIBRARY];  // The corpus library, restored after library_update
+    int library_size;
+    int library_version;
+} Corpus;
+
+typedef void (*BenchFn)(Corpus* c, int i);
+
+typedef struct {
+    const char* name;
+    BenchFn fn;
+    FitnessFn fitness;
+    BenchFn reset;              // Before every operation and after the run; left out of
+                                // the times and allocations, not the hardware counters
+} Bench;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t node_allocs(void) {
+    AllocStats alloc;
+    gp_alloc_stats(&alloc);
+    return alloc.heap_nodes + alloc.arena_nodes;
+}
+
+// Kernels; i counts operations and picks the corpus entry
+
+static void bench_execute_node(Corpus* c, int i) {
+    int k = i % c->size;
+    Context ctx = c->contexts[k];
+    execute_node(c->progs[k]->root, &ctx, c->pop);
+}
+
+static void bench_execute_program(Corpus* c, int i) {
+    int k = i % c->size;
+    Context ctx = c->contexts[k];
+    execute_program(c->progs[k], &ctx, c->pop);
+}
+
+static void bench_execute_linear(Corpus* c, int i) {
+    int k = i % c->size;
+    Context ctx = c->contexts[k];
+    execute_linear(c->linear[k], &ctx, c->pop);
+}
+
+static void bench_bytecode_compile(Corpus* c, int i) {
+    bytecode_destroy(bytecode_compile(c->progs[i % c->size]->root));
+}
+
+static void bench_node_copy(Corpus* c, int i) {
+    node_destroy(node_copy(c->progs[i % c->size]->root));
+}
+
+static void bench_prog_copy(Corpus* c, int i) {
+    prog_destroy(prog_copy(c->progs[i % c->size]));
+}
+
+static void bench_crossover(Corpus* c, int i) {
+    Program* a = c->progs[i % c->size];
+    Program* b = c->progs[(i * 7 + 3) % c->size];
+    prog_destroy(evolve_crossover(a, b));
+}
+
+static void bench_linear_crossover(Corpus* c, int i) {
+    LinearTree* a = c->linear[i % c->size];
+    LinearTree* b = c->linear[(i * 7 + 3) % c->size];
+    linear_destroy(linear_crossover(a, b));
+}
+
+static void bench_mutate(Corpus* c, int i) {
+    prog_destroy(evolve_mutate(c->progs[i % c->size], c->pop));
+}
+
+static void bench_tournament(Corpus* c, int i) {
+    (void)i;
+    tournament_select(c->pop);
+}
+
+static void bench_library_update(Corpus* c, int i) {
+    (void)i;
+    library_update(c->pop);
+}
+
+// Put the corpus library back, so every library_update starts from the same
+// library and later benchmarks don't run against a relearned one
+static void library_restore(Corpus* c, int i) {
+    (void)i;
+    Population* pop = c->pop;
+    for (int k = 0; k < pop->library_size; k++) {
+        node_destroy(pop->library[k].tree);
+        bytecode_destroy(pop->library[k].code);
+    }
+    for (int k = 0; k < c->library_size; k++) {
+        pop->library[k] = c->library[k];
+        pop->library[k].tree = node_copy(c->library[k].tree);
+        pop->library[k].code = bytecode_copy(c->library[k].code);
+    }
+    pop->library_size = c->library_size;
+    pop->library_version = c->library_version;
+}
+
+static void bench_fitness(Corpus* c, int i) {
+    Rng rng;
+    rng_seed(&rng, rng_derive(c->seed, (uint64_t)i, 0));
+    c->fitness(c->progs[i % c->size], NULL, &rng);
+}
+
+static const Bench benches[] = {
+    {"execute_node", bench_execute_node, NULL},
+    {"execute_program", bench_execute_program, NULL},
+    {"execute_linear", bench_execute_linear, NULL},
+    {"bytecode_compile", bench_bytecode_compile, NULL},
+    {"node_copy", bench_node_copy, NULL},
+    {"prog_copy", bench_prog_copy, NULL},
+    {"evolve_crossover", bench_crossover, NULL},
+    {"linear_crossover", bench_linear_crossover, NULL},
+    {"evolve_mutate", bench_mutate, NULL},
+    {"tournament_select", bench_tournament, NULL},
+    {"library_update", bench_library_update, NULL, library_restore},
+    {"fitness/add", bench_fitness, evaluate_add},
+    {"fitness/adf", bench_fitness, evaluate_add_adf},
+    {"fitness/cartpole", bench_fitness, evaluate_cartpole},
+    {"fitness/maze", bench_fitness, evaluate_maze},
+    {"fitness/mux", bench_fitness, evaluate_mux},
+    {"fitness/parity", bench_fitness, evaluate_parity},
+    {"fitness/sequence", bench_fitness, evaluate_sequence},
+    {"fitness/taxi", bench_fitness, evaluate_taxi},
+};
+
+#define NUM_BENCHES ((int)(sizeof(benches) / sizeof(benches[0])))
+
+static void corpus_build(Corpus* c, uint64_t seed, int size) {
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.seed = seed;
+    cfg.pop_size = size;
+    cfg.num_threads = 1;
+    cfg.stats_json = NULL;
+    c->pop = pop_create_config(&cfg);
+    for (int g = 0; g < CORPUS_GENERATIONS; g++) {
+        evolve_generation(c->pop, evaluate_cartpole, NULL, 4);
+    }
+
+    // Score the current generation so tournaments and library learning see
+    // real fitness values
+    c->seed = seed;
+    c->size = size;
+    c->progs = c->pop->programs;
+    c->contexts = calloc(size, sizeof(Context));
+    c->linear = calloc(size, sizeof(LinearTree*));
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (int i = 0; i < size; i++) {
+        Rng episodes;
+        rng_seed(&episodes, rng_derive(seed, 0, 0));
+        c->progs[i]->fitness = evaluate_cartpole(c->progs[i], NULL, &episodes);
+        c->contexts[i].num_inputs = 4;
+        for (int k = 0; k < 4; k++) c->contexts[i].inputs[k] = rng_int(&rng, 200) - 100;
+    }
+    pop_rank(c->pop);
+    for (int i = 0; i < size; i++) c->linear[i] = linear_from_tree(c->progs[i]->root);
+
+    Population* pop = c->pop;
+    for (int k = 0; k < pop->library_size; k++) {
+        c->library[k] = pop->library[k];
+        c->library[k].tree = node_copy(pop->library[k].tree);
+        c->library[k].code = bytecode_copy(pop->library[k].code);
+    }
+    c->library_size = pop->library_size;
+    c->library_version = pop->library_version;
+}
+
+static void corpus_destroy(Corpus* c) {
+    for (int k = 0; k < c->library_size; k++) {
+        node_destroy(c->library[k].tree);
+        bytecode_destroy(c->library[k].code);
+    }
+    for (int i = 0; i < c->size; i++) linear_destroy(c->linear[i]);
+    free(c->linear);
+    free(c->contexts);
+    pop_destroy(c->pop);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const double* sorted, int n, double p) {
+    int k = (int)ceil(p / 100.0 * n) - 1;
+    if (k < 0) k = 0;
+    if (k >= n) k = n - 1;
+    return sorted[k];
+}
+
+static void run_bench(const Bench* b, Corpus* c, int num_samples, int json) {
+    c->fitness = b->fitness;
+    gp_seed(c->seed);
+
+    // Warm up for one sample's worth of time and size batches from it
+    int warm = 0;
+    double start = now_ns();
+    while (now_ns() - start < SAMPLE_NS) {
+        if (b->reset) b->reset(c, warm);
+        b->fn(c, warm++);
+    }
+    double per_op = (now_ns() - start) / warm;
+    int batch = (int)(SAMPLE_NS / per_op);
+    if (batch < MIN_BATCH) batch = MIN_BATCH;
+
+    // Every sample repeats the same operations with the same random draws,
+    // so the spread is timing noise rather than corpus variety
+    double samples[num_samples];
+    uint64_t allocs = node_allocs();
+    uint64_t nodes = gp_nodes_executed();
+    uint64_t perf_start[PERF_COUNT], perf[PERF_COUNT];
+    perf_read(c->perf, perf_start);
+    uint64_t reset_allocs = 0;
+    for (int s = 0; s < num_samples; s++) {
+        gp_seed(c->seed);
+        if (b->reset) {
+            // Time each operation on its own to leave the reset out
+            double total = 0;
+            for (int k = 0; k < batch; k++) {
+                uint64_t before = node_allocs();
+                b->reset(c, k);
+                reset_allocs += node_allocs() - before;
+                double t0 = now_ns();
+                b->fn(c, k);
+                total += now_ns() - t0;
+            }
+            samples[s] = total / batch;
+            continue;
+        }
+        double t0 = now_ns();
+        for (int k = 0; k < batch; k++) b->fn(c, k);
+        samples[s] = (now_ns() - t0) / batch;
+    }
+    perf_read(c->perf, perf);
+    if (b->reset) b->reset(c, 0);
+    double ops = (double)batch * num_samples;
+    double allocs_per_op = (double)(node_allocs() - allocs - reset_allocs) / ops;
+    nodes = gp_nodes_executed() - nodes;
+    unsigned available = perf_available(c->perf);
+    for (int e = 0; e < PERF_COUNT; e++) perf[e] = perf[e] > perf_start[e] ? perf[e] - perf_start[e] : 0;
+
+    double mean = 0;
+    for (int s = 0; s < num_samples; s++) mean += samples[s];
+    mean /= num_samples;
+    qsort(samples, num_samples, sizeof(double), compare_double);
+
+    if (json) {
+        printf("{\"bench\":\"%s\",\"seed\":%llu,\"corpus\":%d,\"samples\":%d,\"ops_per_sample\":%d,"
+               "\"ns_mean\":%.1f,\"ns_min\":%.1f,\"ns_p50\":%.1f,\"ns_p90\":%.1f,\"ns_p99\":%.1f,"
+               "\"ns_max\":%.1f,\"node_allocs_per_op\":%.2f,\"nodes_per_op\":%.1f",
+               b->name, (unsigned long long)c->seed, c->size, num_samples, batch, mean,
+               samples[0], percentile(samples, num_samples, 50), percentile(samples, num_samples, 90),
+               percentile(samples, num_samples, 99), samples[num_samples - 1], allocs_per_op,
+               nodes / ops);
+        for (int e = 0; e < PERF_COUNT; e++) {
+            if (!(available & (1u << e))) continue;
+            printf(",\"%s_per_op\":%.2f", gp_perf_names[e], perf[e] / ops);
+            if (nodes) printf(",\"%s_per_node\":%.4f", gp_perf_names[e], (double)perf[e] / nodes);
+        }
+        if ((available & 3) == 3 && perf[PERF_CYCLES]) {
+            printf(",\"ipc\":%.3f", (double)perf[PERF_INSTRUCTIONS] / perf[PERF_CYCLES]);
+        }
+        printf("}\n");
+    } else {
+        printf("%-20s %12.1f %12.1f %12.1f %12.1f %10.2f\n", b->name, samples[0],
+               percentile(samples, num_samples, 50), percentile(samples, num_samples, 90),
+               percentile(samples, num_samples, 99), allocs_per_op);
+        if (available) {
+            printf("%20s", "");
+            if ((available & 3) == 3 && perf[PERF_CYCLES]) {
+                printf(" ipc %.2f", (double)perf[PERF_INSTRUCTIONS] / perf[PERF_CYCLES]);
+            }
+            for (int e = 0; e < PERF_COUNT; e++) {
+                if (!(available & (1u << e))) continue;
+                printf(" %s/op %.1f", gp_perf_names[e], perf[e] / ops);
+                if (nodes) printf(" (%.3f/node)", (double)perf[e] / nodes);
+            }
+            printf("\n");
+        }
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = 1;
+    int num_samples = 25;
+    int corpus_size = 512;
+    int json = 0;
+    int perf = 0;
+    const char* filter = NULL;
+
+    const char* env = getenv("GP_SEED");
+    if (env) seed = strtoull(env, NULL, 0);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = 1;
+        if (strcmp(argv[i], "--perf") == 0) perf = 1;
+        if (strcmp(argv[i], "--list") == 0) {
+            for (int b = 0; b < NUM_BENCHES; b++) printf("%s\n", benches[b].name);
+            return 0;
+        }
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) num_samples = atoi(argv[++i]);
+        if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) corpus_size = atoi(argv[++i]);
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+    }
+    if (num_samples < 1) num_samples = 1;
+    if (corpus_size < 2) corpus_size = 2;
+
+    Corpus corpus;
+    corpus_build(&corpus, seed, corpus_size);
+    corpus.perf = perf ? perf_open() : NULL;
+
+    if (!json) {
+        printf("GP kernel microbenchmarks\n");
+        printf("=========================\n\n");
+        printf("Seed: %llu, corpus: %d programs (cartpole generation %d), %d samples\n\n",
+               (unsigned long long)seed, corpus_size, CORPUS_GENERATIONS, num_samples);
+        if (perf && !perf_available(corpus.perf)) {
+            printf("Hardware counters: unavailable (no PMU access here; see perf_event_paranoid)\n\n");
+        }
+        printf("%-20s %12s %12s %12s %12s %10s\n", "benchmark", "min ns/op", "p50", "p90", "p99",
+               "allocs/op");
+    }
+
+    for (int b = 0; b < NUM_BENCHES; b++) {
+        if (filter && !strstr(benches[b].name, filter)) continue;
+        run_bench(&benches[b], &corpus, num_samples, json);
+    }
+
+    perf_close(corpus.perf);
+    corpus_destroy(&corpus);
+    return 0;
+}
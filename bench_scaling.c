@@ -0,0 +1,147 @@
+#include "gp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Thread scaling benchmark. Runs the same fixed-seed cartpole evolution with
+// 1, 2, 4, ... threads for several population sizes and reports speedup and
+// parallel efficiency relative to one thread, both for whole generations and
+// for the evaluation phase alone, plus time spent waiting on locks.
+// Generational runs are bit-identical across thread counts, so every row
+// does the same work; the "same" column checks that.
+
+float evaluate_cartpole(Program* prog, void* data, Rng* rng);  // test_cartpole.c
+
+#define MAX_POPS 16
+
+typedef struct {
+    int threads;
+    double wall;            // Sum of stats.wall_time
+    double eval;            // Sum of phase_wall[PHASE_EVAL]
+    double lock_wait;       // pop->lock + cache shards + slot spinlocks
+    uint64_t contentions;
+    uint64_t evaluations;
+    float best;
+    float avg;
+} ScalingRun;
+
+static ScalingRun run_config(uint64_t seed, int pop_size, int threads, int generations, int steady) {
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.seed = seed;
+    cfg.pop_size = pop_size;
+    cfg.num_threads = threads;
+    cfg.stats_json = NULL;
+    Population* pop = pop_create_config(&cfg);
+
+    ScalingRun run = {0};
+    run.threads = pop->num_threads;
+    for (int g = 0; g < generations; g++) {
+        if (steady) {
+            evolve_steady_state(pop, evaluate_cartpole, NULL, 4, pop->pop_size);
+        } else {
+            evolve_generation(pop, evaluate_cartpole, NULL, 4);
+        }
+        GenerationStats* stats = &pop->stats;
+        run.wall += stats->wall_time;
+        run.eval += stats->phase_wall[PHASE_EVAL];
+        run.lock_wait += stats->lock_wait + stats->cache_lock_wait + stats->slot_lock_wait;
+        run.contentions += stats->lock_contentions;
+        run.evaluations += stats->evaluations;
+    }
+    run.best = pop->best_fitness;
+    run.avg = pop->avg_fitness;
+    pop_destroy(pop);
+    return run;
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = 1;
+    int max_threads = gp_available_cpus();
+    int generations = 10;
+    int steady = 0;
+    int json = 0;
+    int pops[MAX_POPS] = {500, 2000, 8000};
+    int num_pops = 3;
+
+    const char* env = getenv("GP_SEED");
+    if (env) seed = strtoull(env, NULL, 0);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = 1;
+        if (strcmp(argv[i], "--steady") == 0) steady = 1;
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) max_threads = atoi(argv[++i]);
+        if (strcmp(argv[i], "--gens") == 0 && i + 1 < argc) generations = atoi(argv[++i]);
+        if (strcmp(argv[i], "--pops") == 0 && i + 1 < argc) {
+            // Comma-separated population sizes
+            num_pops = 0;
+            for (char* s = argv[++i]; *s && num_pops < MAX_POPS;) {
+                char* end;
+                int n = (int)strtol(s, &end, 10);
+                if (end == s) break;
+                if (n > 0) pops[num_pops++] = n;
+                s = (*end == ',') ? end + 1 : end;
+            }
+        }
+    }
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > GP_MAX_THREADS) max_threads = GP_MAX_THREADS;
+    if (generations < 1) generations = 1;
+
+    // 1, 2, 4, ... and max_threads itself
+    int thread_counts[32];
+    int num_counts = 0;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts[num_counts++] = t;
+    thread_counts[num_counts++] = max_threads;
+
+    if (!json) {
+        printf("Thread scaling - CartPole\n");
+        printf("=========================\n\n");
+        printf("Seed: %llu, %d generations per run, %s, %d CPUs available\n",
+               (unsigned long long)seed, generations,
+               steady ? "steady state" : "generational", gp_available_cpus());
+        if (max_threads > gp_available_cpus()) {
+            printf("Note: more threads than available CPUs, expect efficiency to drop\n");
+        }
+    }
+
+    for (int p = 0; p < num_pops; p++) {
+        if (!json) {
+            printf("\nPopulation %d\n", pops[p]);
+            printf("%7s %10s %8s %6s %10s %8s %6s %12s %11s %5s\n", "threads", "gen (s)", "speedup",
+                   "eff", "eval (s)", "speedup", "eff", "lock wait ms", "contentions", "same");
+        }
+
+        ScalingRun base = {0};
+        for (int c = 0; c < num_counts; c++) {
+            ScalingRun run = run_config(seed, pops[p], thread_counts[c], generations, steady);
+            if (c == 0) base = run;
+
+            double speedup = run.wall > 0 ? base.wall / run.wall : 0.0;
+            double eval_speedup = run.eval > 0 ? base.eval / run.eval : 0.0;
+            // Steady-state runs depend on thread timing, so only the
+            // generational ones are expected to match
+            int same = run.best == base.best && run.avg == base.avg;
+
+            if (json) {
+                printf("{\"pop\":%d,\"threads\":%d,\"mode\":\"%s\",\"seed\":%llu,\"generations\":%d,"
+                       "\"wall\":%.6f,\"speedup\":%.3f,\"efficiency\":%.3f,"
+                       "\"eval\":%.6f,\"eval_speedup\":%.3f,\"eval_efficiency\":%.3f,"
+                       "\"evals_per_sec\":%.1f,\"lock_wait\":%.6f,\"lock_contentions\":%llu,"
+                       "\"same_result\":%s}\n",
+                       pops[p], run.threads, steady ? "steady" : "generational",
+                       (unsigned long long)seed, generations, run.wall, speedup,
+                       speedup / run.threads, run.eval, eval_speedup, eval_speedup / run.threads,
+                       run.wall > 0 ? run.evaluations / run.wall : 0.0, run.lock_wait,
+                       (unsigned long long)run.contentions, same ? "true" : "false");
+            } else {
+                printf("%7d %10.3f %7.2fx %5.0f%% %10.3f %7.2fx %5.0f%% %12.2f %11llu %5s\n",
+                       run.threads, run.wall, speedup, 100.0 * speedup / run.threads, run.eval,
+                       eval_speedup, 100.0 * eval_speedup / run.threads, run.lock_wait * 1e3,
+                       (unsigned long long)run.contentions, steady ? "-" : same ? "yes" : "NO");
+            }
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -1,8 +1,12 @@
 #include "gp.h"
+#include "cartpole.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 // CartPole environment
 #define GRAVITY 9.8
@@ -21,11 +25,11 @@ typedef struct {
     float x, x_dot, theta, theta_dot;
 } CartPoleState;
 
-void cartpole_reset(CartPoleState* state) {
-    state->x = ((rand() % 200) - 100) / 1000.0;
-    state->x_dot = ((rand() % 200) - 100) / 1000.0;
-    state->theta = ((rand() % 200) - 100) / 1000.0;
-    state->theta_dot = ((rand() % 200) - 100) / 1000.0;
+void cartpole_reset(CartPoleState* state, Rng* rng) {
+    state->x = (rng_int(rng, 200) - 100) / 1000.0;
+    state->x_dot = (rng_int(rng, 200) - 100) / 1000.0;
+    state->theta = (rng_int(rng, 200) - 100) / 1000.0;
+    state->theta_dot = (rng_int(rng, 200) - 100) / 1000.0;
 }
 
 int cartpole_is_done(CartPoleState* state) {
@@ -49,7 +53,7 @@ void cartpole_step(CartPoleState* state, int action) {
     state->theta_dot += TAU * theta_acc;
 }
 
-float evaluate_cartpole(Program* prog, void* data) {
+float evaluate_cartpole(Program* prog, void* data, Rng* rng) {
     (void)data;
 
     int num_episodes = 10;
@@ -58,7 +62,7 @@ float evaluate_cartpole(Program* prog, void* data) {
 
     for (int ep = 0; ep < num_episodes; ep++) {
         CartPoleState state;
-        cartpole_reset(&state);
+        cartpole_reset(&state, rng);
 
         for (int step = 0; step < max_steps; step++) {
             Context ctx = {0};
@@ -89,22 +93,268 @@ float evaluate_cartpole(Program* prog, void* data) {
     return fitness;
 }
 
-int main() {
-    srand(time(NULL));
+// Island-model run: num_islands subpopulations evolved without a shared
+// generation barrier, migrating along a ring
+static int run_islands(const PopConfig* cfg, int num_islands, int generations) {
+    IslandConfig icfg;
+    island_config_default(&icfg);
+    icfg.num_islands = num_islands;
+    icfg.pop = *cfg;
+
+    IslandModel* model = island_create(&icfg);
+    printf("Islands: %d x %d programs, migration every %d generations (ring)\n\n",
+           island_count(model), cfg->pop_size, icfg.migration_interval);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int gen = 0; gen < generations; gen += 10) {
+        int step = generations - gen < 10 ? generations - gen : 10;
+        island_evolve(model, evaluate_cartpole, NULL, 4, step);
+        Population* best = island_population(model, island_best_index(model));
+        printf("Gen %3d: Best=%.1f (island %d) Size=%d\n",
+               gen + step - 1, best->best_fitness, island_best_index(model),
+               best->best ? best->best->size : 0);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("\n%d generations completed in %.2f seconds\n\n", generations, elapsed);
+
+    for (int i = 0; i < island_count(model); i++) {
+        IslandStats st;
+        island_stats(model, i, &st);
+        printf("  Island %2d: gen %d best %.1f, migrants sent %llu received %llu\n",
+               i, st.generation, st.best_fitness,
+               (unsigned long long)st.migrants_sent, (unsigned long long)st.migrants_received);
+    }
+
+    island_destroy(model);
+    return 0;
+}
+
+// Multi-process run: each island is a forked process exchanging migrants
+// through a coordinator in this process over a Unix socket
+static void run_island_process(const PopConfig* cfg, const char* address, int num_processes, int generations) {
+    MigrationClient* client = migration_connect(address);
+    if (!client) {
+        fprintf(stderr, "Could not reach coordinator at %s\n", address);
+        exit(1);
+    }
+
+    PopConfig pcfg = *cfg;
+    int id = migration_island_id(client);
+    pcfg.seed = rng_derive(cfg->seed, (uint64_t)id, 0);
+    pcfg.num_threads = gp_available_cpus() / num_processes;
+    if (pcfg.num_threads < 1) pcfg.num_threads = 1;
+    Population* pop = pop_create_config(&pcfg);
+
+    for (int gen = 0; gen < generations; gen++) {
+        if (gen > 0 && gen % 10 == 0) migration_exchange(client, pop, 5);
+        evolve_generation(pop, evaluate_cartpole, NULL, 4);
+    }
+
+    MigrationLinkStats st;
+    migration_stats(client, &st);
+    printf("  Process %2d: best %.1f, sent %llu migrants (%llu bytes), received %llu (%llu bytes), "
+           "latency avg %.3f ms max %.3f ms\n",
+           id, pop->best_fitness,
+           (unsigned long long)st.migrants_sent, (unsigned long long)st.bytes_sent,
+           (unsigned long long)st.migrants_received, (unsigned long long)st.bytes_received,
+           st.frames_received ? st.latency_total / st.frames_received * 1e3 : 0.0,
+           st.latency_max * 1e3);
+    fflush(stdout);
+
+    migration_close(client);
+    pop_destroy(pop);
+    exit(0);
+}
+
+static int run_processes(const PopConfig* cfg, int num_processes, int generations) {
+    char address[64];
+    snprintf(address, sizeof(address), "unix:/tmp/gp-migrate-%d.sock", (int)getpid());
+    PopConfig pcfg = *cfg;
+    if (pcfg.seed == 0) pcfg.seed = (uint64_t)time(NULL);
+    printf("Processes: %d x %d programs, migration every 10 generations (ring) via %s\n",
+           num_processes, cfg->pop_size, address);
+    printf("Seed: %llu\n\n", (unsigned long long)pcfg.seed);
+    fflush(stdout);
+
+    for (int i = 0; i < num_processes; i++) {
+        if (fork() == 0) run_island_process(&pcfg, address, num_processes, generations);
+    }
+
+    MigrationLinkStats* links = calloc(num_processes, sizeof(MigrationLinkStats));
+    int rc = migration_coordinator_run(address, num_processes, TOPOLOGY_RING, links);
+    for (int i = 0; i < num_processes; i++) wait(NULL);
+
+    printf("\nCoordinator links:\n");
+    for (int i = 0; i < num_processes; i++) {
+        printf("  Link %2d: in %llu frames (%llu bytes), out %llu frames (%llu bytes), "
+               "%llu dropped, latency avg %.3f ms max %.3f ms\n",
+               i,
+               (unsigned long long)links[i].frames_received, (unsigned long long)links[i].bytes_received,
+               (unsigned long long)links[i].frames_sent, (unsigned long long)links[i].bytes_sent,
+               (unsigned long long)links[i].frames_dropped,
+               links[i].frames_received ? links[i].latency_total / links[i].frames_received * 1e3 : 0.0,
+               links[i].latency_max * 1e3);
+    }
+    free(links);
+    return rc == 0 ? 0 : 1;
+}
+
+// Hardware counters per phase, plus the evaluation phase per executed node
+// and breeding per offspring
+static void print_perf(unsigned available, unsigned long long perf[PHASE_COUNT][PERF_COUNT],
+                       unsigned long long nodes, unsigned long long offspring) {
+    if (!available) {
+        printf("\nHardware counters: unavailable (no PMU access here; see perf_event_paranoid)\n");
+        return;
+    }
+    printf("\nHardware counters:\n  %-8s", "");
+    for (int e = 0; e < PERF_COUNT; e++) {
+        if (available & (1u << e)) printf(" %14s", gp_perf_names[e]);
+    }
+    printf(" %6s\n", "IPC");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        printf("  %-8s", gp_phase_names[p]);
+        for (int e = 0; e < PERF_COUNT; e++) {
+            if (available & (1u << e)) printf(" %14llu", perf[p][e]);
+        }
+        unsigned long long cycles = perf[p][PERF_CYCLES];
+        if ((available & 3) == 3 && cycles > 0) {
+            printf(" %6.2f", (double)perf[p][PERF_INSTRUCTIONS] / cycles);
+        }
+        printf("\n");
+    }
+
+    struct { const char* what; int phase; unsigned long long count; } per[] = {
+        {"executed node", PHASE_EVAL, nodes},
+        {"offspring", PHASE_BREED, offspring},
+    };
+    for (int i = 0; i < 2; i++) {
+        if (per[i].count == 0) continue;
+        printf("  Per %s:", per[i].what);
+        for (int e = 0; e < PERF_COUNT; e++) {
+            if (available & (1u << e)) {
+                printf(" %s %.3f", gp_perf_names[e], (double)perf[per[i].phase][e] / per[i].count);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int use_arena = 1;
+    int static_chunks = 0;
+    int generations = 100;
+    int num_islands = 0;
+    int num_processes = 0;
+    int steady = 0;
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.input_ranges = cartpole_input_ranges;
+    cfg.num_input_ranges = 4;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-arena") == 0) use_arena = 0;
+        if (strcmp(argv[i], "--static") == 0) static_chunks = 1;
+        if (strcmp(argv[i], "--steady") == 0) steady = 1;
+        if (strcmp(argv[i], "--pipeline") == 0) cfg.pipeline = 1;
+        if (strcmp(argv[i], "--pop") == 0 && i + 1 < argc) cfg.pop_size = atoi(argv[++i]);
+        if (strcmp(argv[i], "--gens") == 0 && i + 1 < argc) generations = atoi(argv[++i]);
+        if (strcmp(argv[i], "--islands") == 0 && i + 1 < argc) num_islands = atoi(argv[++i]);
+        if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc) num_processes = atoi(argv[++i]);
+        if (strcmp(argv[i], "--stats-json") == 0 && i + 1 < argc) cfg.stats_json = argv[++i];
+        if (strcmp(argv[i], "--perf") == 0) cfg.perf_counters = 1;
+        if (strcmp(argv[i], "--share") == 0) cfg.share_subtrees = 1;
+        if (strcmp(argv[i], "--simplify") == 0 && i + 1 < argc) {
+            cfg.simplify = simplify_mode_parse(argv[++i]);
+            if (cfg.simplify < 0) {
+                fprintf(stderr, "--simplify takes off, eval or genotype\n");
+                return 1;
+            }
+        }
+    }
 
     printf("Multi-threaded GP Benchmark - CartPole\n");
     printf("======================================\n\n");
-    printf("Population: %d, Fixed generations: 100\n\n", POP_SIZE);
+    printf("Population: %d, Fixed generations: %d\n", cfg.pop_size, generations);
+    printf("Node allocation: %s\n", cfg.share_subtrees ? "hash-consed shared subtrees" :
+                                    use_arena ? "generation arenas" : "calloc/free");
+    if (num_islands > 0) return run_islands(&cfg, num_islands, generations);
+    if (num_processes > 0) return run_processes(&cfg, num_processes, generations);
+
+    Population* pop = pop_create_config(&cfg);
+    pop->use_arena = use_arena;
+    if (static_chunks) {
+        // One contiguous chunk per thread, in population order
+        pop->eval_batch = (pop->pop_size + pop->num_threads - 1) / pop->num_threads;
+        pop->eval_largest_first = 0;
+    }
+    printf("Seed: %llu\n", (unsigned long long)pop->seed);
+    printf("Evaluation: %d threads, %s\n\n", pop->num_threads,
+           steady ? "steady state (pop_size offspring per generation)" :
+           static_chunks ? "static chunks" : "dynamic batches, largest first");
+    if (pop->pipeline) printf("Pipelined: breeding overlaps evaluation, library learned in the background\n\n");
+    if (pop->simplify) {
+        printf("Simplification: %s\n\n", pop->simplify == SIMPLIFY_GENOTYPE ? "genotype (offspring inherit it)"
+                                                                             : "evaluation copies only");
+    }
+    gp_alloc_stats_reset();
 
-    Population* pop = pop_create();
+    double busy[GP_MAX_THREADS] = {0};
+    double idle[GP_MAX_THREADS] = {0};
+    unsigned long long cache_hits = 0, cache_misses = 0;
+    unsigned long long evaluations = 0;
+    double phase_wall[PHASE_COUNT] = {0};
+    double phase_cpu[PHASE_COUNT] = {0};
+    double eval_time = 0;
+    unsigned long long nodes = 0;
+    unsigned long long perf[PHASE_COUNT][PERF_COUNT] = {{0}};
+    unsigned long long offspring = 0;
+    OpProfile ops = {{0}};
+    double overlap_breed = 0;
+    unsigned long long simplify_in = 0, simplify_out = 0, dead_nodes = 0, simplified = 0;
+    unsigned long long overlap_offspring = 0;
 
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    for (int gen = 0; gen < 100; gen++) {
-        evolve_generation(pop, evaluate_cartpole, NULL, 4);
+    for (int gen = 0; gen < generations; gen++) {
+        if (steady) {
+            evolve_steady_state(pop, evaluate_cartpole, NULL, 4, pop->pop_size);
+        } else {
+            evolve_generation(pop, evaluate_cartpole, NULL, 4);
+        }
+        evaluations += pop->stats.evaluations;
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            phase_wall[p] += pop->stats.phase_wall[p];
+            phase_cpu[p] += pop->stats.phase_cpu[p];
+        }
+        eval_time += pop->stats.eval_time;
+        nodes += pop->stats.nodes_executed;
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            for (int e = 0; e < PERF_COUNT; e++) perf[p][e] += pop->stats.phase_perf[p][e];
+        }
+        offspring += pop->pop_size - pop->elite_size;
+        for (int op = 0; op < OP_COUNT; op++) {
+            ops.count[op] += pop->stats.ops.count[op];
+            ops.cycles[op] += pop->stats.ops.cycles[op];
+        }
+        overlap_breed += pop->stats.overlap_breed_time;
+        simplify_in += pop->stats.simplify_nodes_in;
+        simplify_out += pop->stats.simplify_nodes_out;
+        dead_nodes += pop->stats.dead_nodes;
+        simplified += pop->stats.simplify_programs;
+        overlap_offspring += pop->stats.overlap_offspring;
+        for (int t = 0; t < pop->stats.num_threads; t++) {
+            busy[t] += pop->stats.thread_busy[t];
+            idle[t] += pop->stats.thread_idle[t];
+        }
+        cache_hits += pop->stats.cache_hits;
+        cache_misses += pop->stats.cache_misses;
 
-        if (gen % 10 == 0) {
+        if (gen % 10 == 0 || gen == generations - 1) {
             printf("Gen %3d: Best=%.1f Avg=%.1f Size=%d Depth=%d\n",
                    gen,
                    pop->best_fitness,
@@ -119,10 +369,60 @@ int main() {
     double elapsed = (end.tv_sec - start.tv_sec) +
                      (end.tv_nsec - start.tv_nsec) / 1e9;
 
-    printf("\n100 generations completed in %.2f seconds\n", elapsed);
-    printf("Average: %.3f seconds per generation\n", elapsed / 100.0);
+    printf("\n%d generations completed in %.2f seconds\n", generations, elapsed);
+    printf("Average: %.3f seconds per generation\n", elapsed / generations);
+    printf("Throughput: %.0f evaluations/second\n", evaluations / elapsed);
     printf("Final best fitness: %.1f\n", pop->best_fitness);
 
+    AllocStats alloc;
+    gp_alloc_stats(&alloc);
+    printf("\nNode allocations: %llu heap (%llu freed), %llu arena (%llu chunks, %llu resets)\n",
+           (unsigned long long)alloc.heap_nodes,
+           (unsigned long long)alloc.heap_frees,
+           (unsigned long long)alloc.arena_nodes,
+           (unsigned long long)alloc.arena_chunks,
+           (unsigned long long)alloc.arena_resets);
+
+    if (pop->share_subtrees) {
+        printf("Shared subtrees: %llu nodes in the final trees, %llu unique (%.1fx), %llu intern hits\n",
+               (unsigned long long)pop->stats.tree_nodes, (unsigned long long)pop->stats.unique_nodes,
+               pop->stats.unique_nodes ? (double)pop->stats.tree_nodes / pop->stats.unique_nodes : 0.0,
+               (unsigned long long)alloc.shared_hits);
+    }
+
+    printf("Fitness cache: %llu hits, %llu evaluations\n", cache_hits, cache_misses);
+
+    printf("Nodes executed: %llu (%.0f nodes/second of evaluation, %.1f per fitness call)\n",
+           nodes, eval_time > 0 ? nodes / eval_time : 0.0,
+           cache_misses > 0 ? (double)nodes / cache_misses : 0.0);
+    if (simplify_in > 0) {
+        printf("Simplified programs: %llu -> %llu nodes (%.1f%% removed)\n", simplify_in, simplify_out,
+               100.0 * (simplify_in - simplify_out) / simplify_in);
+        printf("Proven dead by input ranges: %llu nodes (%.2f per program)\n", dead_nodes,
+               (double)dead_nodes / simplified);
+    }
+
+    printf("\nPhase times (wall / cpu):\n");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        printf("  %-8s %8.3fs %8.3fs\n", gp_phase_names[p], phase_wall[p], phase_cpu[p]);
+    }
+    if (overlap_offspring > 0) {
+        printf("Overlapped with evaluation: %llu offspring, %.2fs of breeding\n",
+               overlap_offspring, overlap_breed);
+    }
+
+    if (cfg.perf_counters) print_perf(pop->stats.perf_available, perf, nodes, offspring);
+    if (gp_profile_enabled()) {
+        printf("\nOperation profile%s:\n", gp_profile_enabled() > 1 ? " (cycles: VM self time)" : "");
+        gp_profile_print(&ops, cache_misses, stdout);
+    }
+
+    printf("\nEvaluation time per thread:\n");
+    for (int t = 0; t < pop->num_threads; t++) {
+        printf("  Thread %2d: busy %.2fs idle %.2fs (%.1f%% idle)\n", t, busy[t], idle[t],
+               busy[t] + idle[t] > 0 ? 100.0 * idle[t] / (busy[t] + idle[t]) : 0.0);
+    }
+
     pop_destroy(pop);
     return 0;
 }
@@ -0,0 +1,15 @@
+#ifndef CARTPOLE_H
+#define CARTPOLE_H
+
+#include "gp.h"
+
+// CartPole inputs shared by test_cartpole.c and benchmark.c: position,
+// velocity, angle and angular velocity, each state value * 100 as an int.
+// The episode ends once |x| > 2.4 or |theta| > 12 degrees, so a running
+// program only sees x in [-240, 240] and theta in [-20, 20]; the velocities
+// are unbounded.
+static const ValueRange cartpole_input_ranges[4] = {
+    {-240, 240}, {INT32_MIN, INT32_MAX}, {-20, 20}, {INT32_MIN, INT32_MAX},
+};
+
+#endif
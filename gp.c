@@ -1,9 +1,13 @@
+#define _GNU_SOURCE
 #include "gp.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdarg.h>
 
 // Operation metadata
 OpInfo op_info[] = {
@@ -81,17 +85,344 @@ void print_tree(Node* node, int indent) {
     }
 }
 
-// Update program metadata
+// Update program metadata (call after editing prog->root by hand)
 void prog_update_metadata(Program* prog) {
     if (prog && prog->root) {
         prog->depth = node_depth(prog->root);
         prog->size = node_size(prog->root);
+        prog_compile(prog);
     }
 }
 
+// Lower the tree to bytecode; execute_program uses it from then on
+void prog_compile(Program* prog) {
+    if (!prog) return;
+    prog->hash = node_hash(prog->root);
+    bytecode_destroy(prog->code);
+    prog->code = prog->root ? bytecode_compile(prog->root) : NULL;
+}
+
+// Random numbers
+
+static __thread Rng tls_rng;
+static __thread int tls_rng_seeded;
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(Rng* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        seed = splitmix64(seed);
+        rng->s[i] = seed;
+    }
+}
+
+uint64_t rng_next(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+int rng_int(Rng* rng, int n) {
+    // Multiply-shift range reduction on the high 32 bits
+    return (int)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+float rng_float(Rng* rng) {
+    return (rng_next(rng) >> 40) * (1.0f / 16777216.0f);
+}
+
+uint64_t rng_derive(uint64_t seed, uint64_t a, uint64_t b) {
+    return splitmix64(splitmix64(splitmix64(seed) ^ a) ^ b);
+}
+
+Rng* gp_rng(void) {
+    if (!tls_rng_seeded) {
+        rng_seed(&tls_rng, 0);
+        tls_rng_seeded = 1;
+    }
+    return &tls_rng;
+}
+
+void gp_seed(uint64_t seed) {
+    rng_seed(&tls_rng, seed);
+    tls_rng_seeded = 1;
+}
+
+static int random_int(int n) {
+    return rng_int(gp_rng(), n);
+}
+
+// Node arenas
+#define ARENA_CHUNK_NODES 4096
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    int used;
+    Node nodes[ARENA_CHUNK_NODES];
+} ArenaChunk;
+
+struct NodeArena {
+    ArenaChunk* chunks;       // Chunks in use, current one first
+    ArenaChunk* spare;        // Released chunks kept for reuse
+    uint64_t allocated;       // Nodes handed out since the last flush
+    uint64_t new_chunks;
+};
+
+static AllocStats alloc_stats;
+static __thread NodeArena* current_arena;
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&alloc_stats.field, (n), __ATOMIC_RELAXED)
+
+NodeArena* node_arena_create(void) {
+    return calloc(1, sizeof(NodeArena));
+}
+
+static void arena_flush_stats(NodeArena* arena) {
+    STAT_ADD(arena_nodes, arena->allocated);
+    STAT_ADD(arena_chunks, arena->new_chunks);
+    arena->allocated = 0;
+    arena->new_chunks = 0;
+}
+
+static void arena_free_chunks(ArenaChunk* chunk) {
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void node_arena_destroy(NodeArena* arena) {
+    if (!arena) return;
+    arena_flush_stats(arena);
+    arena_free_chunks(arena->chunks);
+    arena_free_chunks(arena->spare);
+    free(arena);
+}
+
+// Release every node in the arena; chunks are kept for the next generation
+void node_arena_reset(NodeArena* arena) {
+    if (!arena) return;
+    arena_flush_stats(arena);
+    while (arena->chunks) {
+        ArenaChunk* chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        chunk->next = arena->spare;
+        arena->spare = chunk;
+    }
+    STAT_ADD(arena_resets, 1);
+}
+
+NodeArena* node_arena_use(NodeArena* arena) {
+    NodeArena* previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+static Node* arena_alloc_node(NodeArena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    if (!chunk || chunk->used == ARENA_CHUNK_NODES) {
+        if (arena->spare) {
+            chunk = arena->spare;
+            arena->spare = chunk->next;
+        } else {
+            chunk = malloc(sizeof(ArenaChunk));
+            arena->new_chunks++;
+        }
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    arena->allocated++;
+
+    Node* n = &chunk->nodes[chunk->used++];
+    memset(n, 0, sizeof(Node));
+    n->alloc = NODE_ARENA;
+    return n;
+}
+
+// Shared subtrees
+//
+// node_intern hash-conses trees into one process-wide table keyed by op,
+// value and child pointers, so structurally identical subtrees anywhere
+// become a single node with an atomic reference count. Shared nodes are
+// never edited: node_share copies a shared tree with one increment, and
+// mutation and crossover copy only the path to what they change. A node
+// whose count drops to zero is unlinked under its shard's lock; a lookup
+// never revives a node at zero, it adds a fresh one instead.
+#define SHARE_SHARDS 64
+
+typedef struct SharedNode {
+    struct SharedNode* next;    // Bucket chain
+    uint32_t refs;
+    uint32_t hash;              // Low bits pick the bucket
+    Node node;
+} SharedNode;
+
+typedef struct {
+    pthread_mutex_t lock;
+    SharedNode** buckets;       // NULL until the first insert
+    uint32_t mask;
+    uint32_t count;
+} ShareShard;
+
+static ShareShard share_shards[SHARE_SHARDS] = {
+    [0 ... SHARE_SHARDS - 1] = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0},
+};
+static uint64_t shared_live;    // Kept apart from alloc_stats, which can be reset
+
+static inline SharedNode* shared_header(Node* node) {
+    return (SharedNode*)((char*)node - offsetof(SharedNode, node));
+}
+
+// Children are shared already, so their addresses stand for their structure
+static uint64_t share_hash(const Node* node) {
+    uint64_t h = splitmix64(((uint64_t)node->op << 48) ^ ((uint64_t)node->type << 40) ^
+                            ((uint64_t)node->num_children << 32) ^ (uint32_t)node->value);
+    for (int i = 0; i < node->num_children; i++) {
+        h = splitmix64(h ^ (uint64_t)(uintptr_t)node->children[i]);
+    }
+    return h;
+}
+
+static int share_same(const Node* a, const Node* b) {
+    if (a->op != b->op || a->type != b->type || a->value != b->value ||
+        a->num_children != b->num_children) {
+        return 0;
+    }
+    for (int i = 0; i < a->num_children; i++) {
+        if (a->children[i] != b->children[i]) return 0;
+    }
+    return 1;
+}
+
+static ShareShard* share_shard(uint64_t h) {
+    return &share_shards[(h >> 32) % SHARE_SHARDS];
+}
+
+static void share_grow(ShareShard* shard) {
+    uint32_t cap = shard->buckets ? (shard->mask + 1) * 2 : 256;
+    SharedNode** buckets = calloc(cap, sizeof(SharedNode*));
+    for (uint32_t b = 0; shard->buckets && b <= shard->mask; b++) {
+        SharedNode* s = shard->buckets[b];
+        while (s) {
+            SharedNode* next = s->next;
+            s->next = buckets[s->hash & (cap - 1)];
+            buckets[s->hash & (cap - 1)] = s;
+            s = next;
+        }
+    }
+    free(shard->buckets);
+    shard->buckets = buckets;
+    shard->mask = cap - 1;
+}
+
+// Take a reference unless the count has already reached zero
+static int share_try_retain(SharedNode* s) {
+    uint32_t refs = __atomic_load_n(&s->refs, __ATOMIC_RELAXED);
+    while (refs) {
+        if (__atomic_compare_exchange_n(&s->refs, &refs, refs + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The shared node equal to key, found or added. Key's children are shared
+// and its references to them are used up either way.
+static Node* share_lookup(const Node* key) {
+    uint64_t h = share_hash(key);
+    ShareShard* shard = share_shard(h);
+    pthread_mutex_lock(&shard->lock);
+    if (shard->buckets) {
+        for (SharedNode* s = shard->buckets[(uint32_t)h & shard->mask]; s; s = s->next) {
+            if (s->hash != (uint32_t)h || !share_same(&s->node, key)) continue;
+            if (!share_try_retain(s)) continue;     // Being released
+            pthread_mutex_unlock(&shard->lock);
+            for (int i = 0; i < key->num_children; i++) node_destroy(key->children[i]);
+            STAT_ADD(shared_hits, 1);
+            return &s->node;
+        }
+    }
+    if (!shard->buckets || shard->count >= 2 * (shard->mask + 1)) share_grow(shard);
+    SharedNode* s = malloc(sizeof(SharedNode));
+    s->refs = 1;
+    s->hash = (uint32_t)h;
+    s->node = *key;
+    s->node.alloc = NODE_SHARED;
+    s->next = shard->buckets[s->hash & shard->mask];
+    shard->buckets[s->hash & shard->mask] = s;
+    shard->count++;
+    pthread_mutex_unlock(&shard->lock);
+    STAT_ADD(heap_nodes, 1);
+    __atomic_fetch_add(&shared_live, 1, __ATOMIC_RELAXED);
+    return &s->node;
+}
+
+static void share_release(Node* node) {
+    SharedNode* s = shared_header(node);
+    if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    ShareShard* shard = share_shard(share_hash(node));
+    pthread_mutex_lock(&shard->lock);
+    for (SharedNode** p = &shard->buckets[s->hash & shard->mask]; *p; p = &(*p)->next) {
+        if (*p == s) {
+            *p = s->next;
+            shard->count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+    for (int i = 0; i < node->num_children; i++) node_destroy(node->children[i]);
+    free(s);
+    STAT_ADD(heap_frees, 1);
+    __atomic_fetch_sub(&shared_live, 1, __ATOMIC_RELAXED);
+}
+
+void gp_alloc_stats(AllocStats* stats) {
+    stats->heap_nodes = __atomic_load_n(&alloc_stats.heap_nodes, __ATOMIC_RELAXED);
+    stats->heap_frees = __atomic_load_n(&alloc_stats.heap_frees, __ATOMIC_RELAXED);
+    stats->arena_nodes = __atomic_load_n(&alloc_stats.arena_nodes, __ATOMIC_RELAXED);
+    stats->arena_chunks = __atomic_load_n(&alloc_stats.arena_chunks, __ATOMIC_RELAXED);
+    stats->arena_resets = __atomic_load_n(&alloc_stats.arena_resets, __ATOMIC_RELAXED);
+    stats->shared_nodes = __atomic_load_n(&shared_live, __ATOMIC_RELAXED);
+    stats->shared_hits = __atomic_load_n(&alloc_stats.shared_hits, __ATOMIC_RELAXED);
+
+    // Include what the calling thread's arena has handed out so far
+    if (current_arena) {
+        stats->arena_nodes += current_arena->allocated;
+        stats->arena_chunks += current_arena->new_chunks;
+    }
+}
+
+void gp_alloc_stats_reset(void) {
+    memset(&alloc_stats, 0, sizeof(alloc_stats));
+}
+
 // Node operations
 Node* node_create(OpType op, int value) {
-    Node* n = calloc(1, sizeof(Node));
+    Node* n;
+    if (current_arena) {
+        n = arena_alloc_node(current_arena);
+    } else {
+        n = calloc(1, sizeof(Node));
+        STAT_ADD(heap_nodes, 1);
+    }
     n->op = op;
     n->value = value;
     OpInfo* info = get_op_info(op);
@@ -113,11 +444,60 @@ Node* node_copy(Node* node) {
 }
 
 void node_destroy(Node* node) {
-    if (!node) return;
+    if (!node || node->alloc == NODE_ARENA) return;
+    if (node->alloc == NODE_SHARED) {
+        share_release(node);
+        return;
+    }
     for (int i = 0; i < node->num_children; i++) {
         node_destroy(node->children[i]);
     }
     free(node);
+    STAT_ADD(heap_frees, 1);
+}
+
+Node* node_intern(Node* node) {
+    if (!node || node->alloc == NODE_SHARED) return node;
+    Node key = {0};
+    key.op = node->op;
+    key.type = node->type;
+    key.value = node->value;
+    key.num_children = node->num_children;
+    for (int i = 0; i < node->num_children; i++) {
+        key.children[i] = node_intern(node->children[i]);
+    }
+    if (node->alloc == NODE_HEAP) {
+        free(node);
+        STAT_ADD(heap_frees, 1);
+    }
+    return share_lookup(&key);
+}
+
+Node* node_share(Node* node) {
+    if (!node || node->alloc != NODE_SHARED) return node_copy(node);
+    __atomic_fetch_add(&shared_header(node)->refs, 1, __ATOMIC_RELAXED);
+    return node;
+}
+
+// A private copy of a shared node (same children, one more reference to
+// each) for an editor to change; the original is left to its owner
+static Node* node_unshare(Node* node) {
+    if (!node || node->alloc != NODE_SHARED) return node;
+    Node* copy = node_create(node->op, node->value);
+    copy->num_children = node->num_children;
+    for (int i = 0; i < node->num_children; i++) {
+        copy->children[i] = node_share(node->children[i]);
+    }
+    return copy;
+}
+
+// node_unshare for an editor that owns a reference to node: that reference
+// moves to the private copy
+static Node* node_own(Node* node) {
+    if (!node || node->alloc != NODE_SHARED) return node;
+    Node* copy = node_unshare(node);
+    node_destroy(node);
+    return copy;
 }
 
 int node_depth(Node* node) {
@@ -139,29 +519,76 @@ int node_size(Node* node) {
     return size;
 }
 
+// Merkle-style hash: op, value and the ordered hashes of the children
+static uint64_t node_hash_leaf(Node* node) {
+    return splitmix64(((uint64_t)node->op << 40) ^ ((uint64_t)node->num_children << 32) ^ (uint32_t)node->value);
+}
+
+static uint64_t node_hash_child(uint64_t h, uint64_t child, int i) {
+    return splitmix64(h ^ rotl64(child, i + 1));
+}
+
+uint64_t node_hash(Node* node) {
+    if (!node) return 0;
+    uint64_t h = node_hash_leaf(node);
+    for (int i = 0; i < node->num_children; i++) {
+        h = node_hash_child(h, node_hash(node->children[i]), i);
+    }
+    return h;
+}
+
+// Structural equality (what node_hash approximates)
+static int node_equal(Node* a, Node* b) {
+    if (a == b) return 1;
+    if (!a || !b) return 0;
+    if (a->op != b->op || a->value != b->value || a->num_children != b->num_children) return 0;
+    for (int i = 0; i < a->num_children; i++) {
+        if (!node_equal(a->children[i], b->children[i])) return 0;
+    }
+    return 1;
+}
+
 // Random tree generation
-static Node* create_random_tree(int depth, ValueType required_type, int num_inputs) {
-    if (depth >= MAX_DEPTH || (depth > 0 && rand() % 3 == 0)) {
+
+// The ops execute_program_bits runs (bit_node_supported in gp_batch.c), for
+// PopConfig.boolean_ops. Their results on constants -2..1 stay in -2..1.
+static int op_is_boolean(OpType op) {
+    switch (op) {
+        case OP_AND: case OP_OR: case OP_XOR: case OP_NOT:
+        case OP_EQ: case OP_LT: case OP_LTE: case OP_GT:
+        case OP_MAX: case OP_MIN: case OP_STEP: case OP_IDENT:
+        case OP_IF: case OP_IF_GT: case OP_SEQ:
+        case OP_OUTPUT: case OP_MEM_WRITE:
+        case OP_INPUT: case OP_MEM_READ: case OP_CONST:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static Node* create_random_tree(int depth, int max_depth, ValueType required_type, int num_inputs,
+                                int boolean) {
+    if (depth >= max_depth || (depth > 0 && random_int(3) == 0)) {
         // Create terminal
         if (required_type == TYPE_INT) {
-            int choice = rand() % 3;
+            int choice = random_int(3);
             if (choice == 0 && num_inputs > 0) {
-                return node_create(OP_INPUT, rand() % num_inputs);
+                return node_create(OP_INPUT, random_int(num_inputs));
             } else if (choice == 1) {
-                return node_create(OP_MEM_READ, rand() % MAX_MEMORY);
+                return node_create(OP_MEM_READ, random_int(MAX_MEMORY));
             } else {
-                return node_create(OP_CONST, (rand() % 20) - 10);
+                return node_create(OP_CONST, boolean ? random_int(4) - 2 : random_int(20) - 10);
             }
         } else {
             // TYPE_VOID - create output or mem_write statement
-            if (rand() % 3 == 0) {
-                Node* mem_write = node_create(OP_MEM_WRITE, rand() % MAX_MEMORY);
-                mem_write->children[0] = create_random_tree(depth + 1, TYPE_INT, num_inputs);
+            if (random_int(3) == 0) {
+                Node* mem_write = node_create(OP_MEM_WRITE, random_int(MAX_MEMORY));
+                mem_write->children[0] = create_random_tree(depth + 1, max_depth, TYPE_INT, num_inputs, boolean);
                 mem_write->num_children = 1;
                 return mem_write;
             } else {
                 Node* out = node_create(OP_OUTPUT, 0);
-                out->children[0] = create_random_tree(depth + 1, TYPE_INT, num_inputs);
+                out->children[0] = create_random_tree(depth + 1, max_depth, TYPE_INT, num_inputs, boolean);
                 out->num_children = 1;
                 return out;
             }
@@ -179,6 +606,7 @@ static Node* create_random_tree(int depth, ValueType required_type, int num_inpu
         if (op == OP_LIBRARY || op == OP_FUNC_CALL || op == OP_PARAM) {
             continue;  // Skip these
         }
+        if (boolean && !op_is_boolean(op)) continue;
         if (op_info[i].return_type == required_type) {
             ops[n_ops++] = op_info[i].op;
         }
@@ -186,29 +614,29 @@ static Node* create_random_tree(int depth, ValueType required_type, int num_inpu
 
     if (n_ops == 0) {
         // Fallback to terminal
-        return create_random_tree(MAX_DEPTH, required_type, num_inputs);
+        return create_random_tree(max_depth, max_depth, required_type, num_inputs, boolean);
     }
 
-    OpType op = ops[rand() % n_ops];
+    OpType op = ops[random_int(n_ops)];
     Node* node = node_create(op, 0);
     OpInfo* info = get_op_info(op);
 
     for (int i = 0; i < info->arity; i++) {
-        node->children[i] = create_random_tree(depth + 1, info->arg_types[i], num_inputs);
+        node->children[i] = create_random_tree(depth + 1, max_depth, info->arg_types[i], num_inputs, boolean);
     }
 
     return node;
 }
 
 // Program operations
-Program* prog_create_random(int max_depth, int num_inputs) {
+static Program* create_random_program(int max_depth, int num_inputs, int boolean) {
     Program* prog = calloc(1, sizeof(Program));
 
     // Create a program that outputs something
     // SEQ(OUTPUT(...), VOID) pattern
     Node* root = node_create(OP_SEQ, 0);
     root->children[0] = node_create(OP_OUTPUT, 0);
-    root->children[0]->children[0] = create_random_tree(0, TYPE_INT, num_inputs);
+    root->children[0]->children[0] = create_random_tree(0, max_depth, TYPE_INT, num_inputs, boolean);
     root->children[1] = node_create(OP_OUTPUT, 0);
     root->children[1]->children[0] = node_create(OP_CONST, 0);  // Dummy second output
 
@@ -216,29 +644,184 @@ Program* prog_create_random(int max_depth, int num_inputs) {
     prog->depth = node_depth(root);
     prog->size = node_size(root);
     prog->fitness = -INFINITY;
+    prog_compile(prog);
 
     return prog;
 }
 
+Program* prog_create_random(int max_depth, int num_inputs) {
+    return create_random_program(max_depth, num_inputs, 0);
+}
+
 Program* prog_copy(Program* prog) {
     if (!prog) return NULL;
     Program* copy = calloc(1, sizeof(Program));
-    copy->root = node_copy(prog->root);
+    copy->root = node_share(prog->root);
     copy->fitness = prog->fitness;
     copy->depth = prog->depth;
     copy->size = prog->size;
+    copy->hash = prog->hash;
+    copy->code = bytecode_copy(prog->code);
     return copy;
 }
 
 void prog_destroy(Program* prog) {
     if (!prog) return;
     node_destroy(prog->root);
+    bytecode_destroy(prog->code);
     free(prog);
 }
 
+// Per-opcode profile (-DGP_PROFILE)
+//
+// Each thread counts into its own table, registered once in a global list
+// so gp_profile_totals can sum them. Only the owner writes a table; stores
+// and the collector's loads are relaxed atomics, so totals read while other
+// threads run are merely a little stale. Tables outlive their threads.
+
+#define VM_SRC_NONE 0x7F        // VmInstr.src of instructions outside any node
+
+#ifdef GP_PROFILE
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define PROFILE_MAX_THREADS 1024
+
+static OpProfile* profile_tables[PROFILE_MAX_THREADS];
+static int profile_num_tables;
+static __thread OpProfile* tls_profile;
+static __thread uint64_t tls_profile_tick;     // Last VM dispatch
+static __thread uint8_t tls_profile_src = VM_SRC_NONE;
+
+static OpProfile* profile_self(void) {
+    if (!tls_profile) {
+        tls_profile = calloc(1, sizeof(OpProfile));
+        int slot = __atomic_fetch_add(&profile_num_tables, 1, __ATOMIC_RELAXED);
+        if (slot < PROFILE_MAX_THREADS) {
+            __atomic_store_n(&profile_tables[slot], tls_profile, __ATOMIC_RELEASE);
+        }
+    }
+    return tls_profile;
+}
+
+static inline void profile_add(uint64_t* counter, uint64_t n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t profile_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+#define PROFILE_NODE(op) profile_add(&profile_self()->count[op], 1)
+#else
+#define PROFILE_NODE(op)
+#endif
+
+int gp_profile_enabled(void) {
+#if defined(GP_PROFILE_CYCLES)
+    return 2;
+#elif defined(GP_PROFILE)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void gp_profile_count(OpType op, uint64_t n) {
+#ifdef GP_PROFILE
+    if ((int)op >= 0 && op < OP_COUNT) profile_add(&profile_self()->count[op], n);
+#else
+    (void)op;
+    (void)n;
+#endif
+}
+
+void gp_profile_totals(OpProfile* out) {
+    memset(out, 0, sizeof(*out));
+#ifdef GP_PROFILE
+    int n = __atomic_load_n(&profile_num_tables, __ATOMIC_RELAXED);
+    if (n > PROFILE_MAX_THREADS) n = PROFILE_MAX_THREADS;
+    for (int t = 0; t < n; t++) {
+        OpProfile* p = __atomic_load_n(&profile_tables[t], __ATOMIC_ACQUIRE);
+        if (!p) continue;
+        for (int op = 0; op < OP_COUNT; op++) {
+            out->count[op] += __atomic_load_n(&p->count[op], __ATOMIC_RELAXED);
+            out->cycles[op] += __atomic_load_n(&p->cycles[op], __ATOMIC_RELAXED);
+        }
+    }
+#endif
+}
+
+void gp_profile_print(const OpProfile* prof, uint64_t evaluations, FILE* out) {
+    uint64_t total = 0, total_cycles = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        total += prof->count[op];
+        total_cycles += prof->cycles[op];
+    }
+    if (total == 0) {
+        fprintf(out, "  (no executions recorded)\n");
+        return;
+    }
+
+    // Most executed first
+    int order[OP_COUNT];
+    for (int i = 0; i < OP_COUNT; i++) order[i] = i;
+    for (int i = 1; i < OP_COUNT; i++) {
+        int op = order[i], j = i;
+        while (j > 0 && prof->count[order[j - 1]] < prof->count[op]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = op;
+    }
+
+    fprintf(out, "  %-10s %16s %7s %12s", "op", "executions", "share", "per eval");
+    if (total_cycles) fprintf(out, " %7s %10s", "cycles", "per exec");
+    fprintf(out, "\n");
+    for (int i = 0; i < OP_COUNT; i++) {
+        int op = order[i];
+        if (!prof->count[op] && !prof->cycles[op]) continue;
+        fprintf(out, "  %-10s %16llu %6.2f%% %12.1f", get_op_info(op)->name,
+                (unsigned long long)prof->count[op], 100.0 * prof->count[op] / total,
+                evaluations ? (double)prof->count[op] / evaluations : 0.0);
+        if (total_cycles) {
+            fprintf(out, " %6.2f%% %10.2f", 100.0 * prof->cycles[op] / total_cycles,
+                    prof->count[op] ? (double)prof->cycles[op] / prof->count[op] : 0.0);
+        }
+        fprintf(out, "\n");
+    }
+}
+
 // Execution
+
+// Nodes / VM instructions executed by this thread, for GenerationStats
+static __thread uint64_t tls_nodes_executed;
+
+#if GP_NODE_COUNT
+#define COUNT_NODES(n) (tls_nodes_executed += (n))
+#else
+#define COUNT_NODES(n) ((void)(n))
+#endif
+
+uint64_t gp_nodes_executed(void) {
+    return tls_nodes_executed;
+}
+
+void gp_count_nodes(uint64_t n) {
+    COUNT_NODES(n);
+}
+
 int execute_node(Node* node, Context* ctx, Population* pop) {
     if (!node) return 0;
+    COUNT_NODES(1);
+    PROFILE_NODE(node->op);
 
     switch (node->op) {
         case OP_ADD: {
@@ -445,332 +1028,3312 @@ int execute_node(Node* node, Context* ctx, Population* pop) {
     }
 }
 
-void execute_program(Program* prog, Context* ctx, Population* pop) {
-    ctx->num_outputs = 0;
-    if (prog && prog->root) {
-        execute_node(prog->root, ctx, pop);
+// Bytecode VM
+//
+// Trees are lowered to postfix code over a value stack. IF/IF_GT compile to
+// conditional jumps so only the taken branch runs, and FUNC_CALL keeps the
+// same argument frame layout in Context as execute_node. LIB/FUNC_CALL look
+// the library entry up when executed, so code stays valid across library
+// updates.
+typedef enum {
+    VM_CONST,        // push arg
+    VM_INPUT,        // push inputs[arg] (bounds checked against ctx)
+    VM_MEM_READ,     // push memory[arg]
+    VM_PARAM,        // push args[frame_base + arg]
+    VM_ADD,
+    VM_SUB,
+    VM_MUL,
+    VM_DIV,
+    VM_MOD,
+    VM_AND,
+    VM_OR,
+    VM_XOR,
+    VM_NOT,
+    VM_EQ,
+    VM_LT,
+    VM_LTE,
+    VM_ABS,
+    VM_NEG,
+    VM_MAX,
+    VM_MIN,
+    VM_GT,
+    VM_SIN,
+    VM_TANH,
+    VM_STEP,
+    VM_OUTPUT,       // pop value, append to outputs, push 0
+    VM_MEM_WRITE,    // pop value into memory[arg], push 0
+    VM_POP,          // discard top
+    VM_VOID,         // replace top with 0
+    VM_JMP,          // jump to arg
+    VM_JZ,           // pop cond, jump to arg if zero
+    VM_JLE,          // pop b, a; jump to arg unless a > b
+    VM_LIB,          // push result of library[arg]
+    VM_CALL_BEGIN,   // open frame for library[arg], aux = #children; jump past call if invalid
+    VM_ARG_GUARD,    // skip to arg when argument aux is not passed
+    VM_PUSH_ARG,     // pop value onto ctx->args
+    VM_CALL,         // run library body with the open frame
+    VM_RET,          // return top of stack
+    VM_REG_LOAD,     // push regs[arg]
+    VM_REG_TRY,      // if regs[aux] is set this run, push it and jump to arg
+    VM_REG_STORE,    // regs[arg] = top, mark it set
+    VM_OP_COUNT
+} VmOp;
+
+typedef struct {
+    uint8_t op;
+    uint8_t aux;
+    uint8_t src;        // OpType compiled from, | VM_SRC_COUNTED on the one
+                        // instruction that runs once per execution of the node
+    int32_t arg;
+} VmInstr;
+
+#define VM_SRC_COUNTED 0x80
+
+struct Bytecode {
+    int length;
+    int max_stack;
+    int max_frames;
+    int num_regs;       // Shared subexpression registers
+    VmInstr instrs[];
+};
+
+// Common subexpressions
+//
+// Crossover and library injection often leave identical subtrees in one
+// program. Before lowering, subtrees whose value can't change during a run
+// (no memory, OUTPUT, parameters or library calls; inputs are fixed) are
+// grouped by structure. A group that occurs more than once gets a register:
+// the first occurrence to run stores its value and later ones push it from
+// the register. An occurrence compiled after one that runs unconditionally
+// (jumps only go forward) is a single REG_LOAD. Occurrences that may be the
+// first to run, inside IF branches or call arguments, test the register's
+// per-run valid bit and compute only if it isn't set. Nothing with side
+// effects is ever skipped or moved, so MEM_WRITE and SEQ ordering is kept.
+#define VM_MAX_REGS 64      // Valid bits fit one word
+#define CSE_MIN_SIZE 3      // Smaller subtrees are cheaper to recompute
+
+typedef struct {
+    uint64_t hash;
+    Node* rep;
+    int count;          // Occurrences outside other occurrences' repeats
+    int reg;            // -1 = compiled normally
+    int seen;           // Occurrences compiled so far
+    int computed;       // Set on every path through the code compiled so far
+} CseClass;
+
+typedef struct {
+    Node* node;         // NULL = empty
+    uint64_t hash;
+    int cls;            // -1 until counted
+} CseNode;
+
+#define CSE_INLINE 128      // Candidates found without touching the heap
+
+typedef struct {
+    // Subtrees worth sharing, in the order cse_scan finds them
+    CseNode* found;
+    int num_found;
+    int found_cap;
+    CseNode found_inline[CSE_INLINE];
+
+    // Built only when two of them hash alike
+    CseNode* nodes;     // Open addressing by node pointer
+    int* classes_by_hash;  // Open addressing by hash, -1 = empty
+    int mask;
+    CseClass* classes;
+    int num_classes;
+} Cse;
+
+static int cse_enabled = 1;
+
+int bytecode_set_cse(int enabled) {
+    int previous = cse_enabled;
+    cse_enabled = enabled;
+    return previous;
+}
+
+static CseNode* cse_node(Cse* cse, Node* node) {
+    uint64_t h = (uint64_t)(uintptr_t)node;
+    for (int i = (int)(splitmix64(h) & cse->mask);; i = (i + 1) & cse->mask) {
+        if (cse->nodes[i].node == node || !cse->nodes[i].node) return &cse->nodes[i];
     }
 }
 
-// Population
-Population* pop_create() {
-    Population* pop = calloc(1, sizeof(Population));
-    pthread_mutex_init(&pop->lock, NULL);
-    pop->best_fitness = -INFINITY;
-    return pop;
+// Hash every subtree; remember the ones worth sharing. Returns the subtree's
+// hash, and its size and whether its value is fixed for the run.
+static uint64_t cse_scan(Cse* cse, Node* node, int* size, int* fixed) {
+    *size = 0;
+    *fixed = 1;
+    if (!node) return 0;
+    uint64_t h = node_hash_leaf(node);
+    *size = 1;
+    for (int i = 0; i < node->num_children; i++) {
+        int child_size, child_fixed;
+        h = node_hash_child(h, cse_scan(cse, node->children[i], &child_size, &child_fixed), i);
+        *size += child_size;
+        if (!child_fixed) *fixed = 0;
+    }
+    switch (node->op) {
+        case OP_MEM_READ:
+        case OP_MEM_WRITE:
+        case OP_OUTPUT:
+        case OP_PARAM:
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+            *fixed = 0;
+            break;
+    }
+    if (*fixed && *size >= CSE_MIN_SIZE) {
+        if (cse->num_found == cse->found_cap) {
+            cse->found_cap *= 2;
+            if (cse->found == cse->found_inline) {
+                cse->found = malloc(sizeof(CseNode) * cse->found_cap);
+                memcpy(cse->found, cse->found_inline, sizeof(cse->found_inline));
+            } else {
+                cse->found = realloc(cse->found, sizeof(CseNode) * cse->found_cap);
+            }
+        }
+        cse->found[cse->num_found++] = (CseNode){node, h, -1};
+    }
+    return h;
+}
+
+// Count occurrences in compile order. A repeat's own subtrees are never
+// counted: once it is served from its register they don't run.
+static void cse_count(Cse* cse, Node* node) {
+    if (!node) return;
+    CseNode* e = cse_node(cse, node);
+    if (e->node) {
+        int i = (int)(e->hash & cse->mask);
+        for (;; i = (i + 1) & cse->mask) {
+            int k = cse->classes_by_hash[i];
+            if (k < 0) {
+                k = cse->num_classes++;
+                cse->classes[k] = (CseClass){e->hash, node, 0, -1, 0, 0};
+                cse->classes_by_hash[i] = k;
+            }
+            if (cse->classes[k].hash == e->hash && node_equal(cse->classes[k].rep, node)) {
+                e->cls = k;
+                break;
+            }
+        }
+        if (++cse->classes[e->cls].count > 1) return;
+    }
+    for (int i = 0; i < node->num_children; i++) cse_count(cse, node->children[i]);
+}
+
+// Whether two candidates hash alike (most programs have none)
+static int cse_any_repeat(Cse* cse) {
+    uint64_t seen_inline[2 * CSE_INLINE];
+    int cap = 16;
+    while (cap < 2 * cse->num_found) cap *= 2;
+    uint64_t* seen = cap <= 2 * CSE_INLINE ? seen_inline : malloc(sizeof(uint64_t) * cap);
+    memset(seen, 0, sizeof(uint64_t) * cap);
+    int repeat = 0;
+    for (int f = 0; f < cse->num_found && !repeat; f++) {
+        uint64_t h = cse->found[f].hash | 1;     // 0 marks empty
+        for (int i = (int)(h >> 1) & (cap - 1);; i = (i + 1) & (cap - 1)) {
+            if (!seen[i]) {
+                seen[i] = h;
+                break;
+            }
+            if (seen[i] == h) {
+                repeat = 1;
+                break;
+            }
+        }
+    }
+    if (seen != seen_inline) free(seen);
+    return repeat;
+}
+
+static void cse_free(Cse* cse) {
+    if (cse->found != cse->found_inline) free(cse->found);
+    free(cse->nodes);
+    free(cse->classes_by_hash);
+    free(cse->classes);
+}
+
+// Returns the number of registers; the tables stay until cse_free
+static int cse_build(Cse* cse, Node* root) {
+    cse->found = cse->found_inline;
+    cse->found_cap = CSE_INLINE;
+    cse->num_found = 0;
+    cse->nodes = NULL;
+    cse->classes_by_hash = NULL;
+    cse->classes = NULL;
+    cse->num_classes = 0;
+    if (!cse_enabled) return 0;
+
+    int size, fixed;
+    cse_scan(cse, root, &size, &fixed);
+    if (cse->num_found < 2 || !cse_any_repeat(cse)) return 0;
+
+    int cap = 16;
+    while (cap < 2 * cse->num_found) cap *= 2;
+    cse->mask = cap - 1;
+    cse->nodes = calloc(cap, sizeof(CseNode));
+    cse->classes_by_hash = malloc(sizeof(int) * cap);
+    memset(cse->classes_by_hash, 0xff, sizeof(int) * cap);
+    cse->classes = malloc(sizeof(CseClass) * cse->num_found);
+    for (int f = 0; f < cse->num_found; f++) *cse_node(cse, cse->found[f].node) = cse->found[f];
+
+    cse_count(cse, root);
+    int regs = 0;
+    for (int k = 0; k < cse->num_classes && regs < VM_MAX_REGS; k++) {
+        if (cse->classes[k].count > 1) cse->classes[k].reg = regs++;
+    }
+    return regs;
+}
+
+typedef struct {
+    VmInstr* instrs;
+    int length;
+    int capacity;
+    int depth;
+    int max_stack;
+    int frames;
+    int max_frames;
+    uint8_t src;        // Node being compiled (for VmInstr.src)
+    int own;            // Its first instruction, -1 until emitted
+    Cse* cse;           // NULL = no shared subexpressions
+    int conditional;    // Inside code that may not run (branches, call arguments)
+} VmCompiler;
+
+static int vm_emit(VmCompiler* c, VmOp op, int aux, int arg, int stack_delta) {
+    if (c->length == c->capacity) {
+        c->capacity = c->capacity ? c->capacity * 2 : 64;
+        c->instrs = realloc(c->instrs, sizeof(VmInstr) * c->capacity);
+    }
+    VmInstr* in = &c->instrs[c->length];
+    in->op = (uint8_t)op;
+    in->aux = (uint8_t)aux;
+    in->src = c->src;
+    in->arg = arg;
+    if (c->own < 0) c->own = c->length;
+    c->depth += stack_delta;
+    if (c->depth > c->max_stack) c->max_stack = c->depth;
+    return c->length++;
 }
 
-void pop_destroy(Population* pop) {
-    if (!pop) return;
-    for (int i = 0; i < POP_SIZE; i++) {
-        prog_destroy(pop->programs[i]);
+static void vm_compile_node(VmCompiler* c, Node* node);
+
+static void vm_compile_binary(VmCompiler* c, Node* node, VmOp op) {
+    vm_compile_node(c, node->children[0]);
+    vm_compile_node(c, node->children[1]);
+    vm_emit(c, op, 0, 0, -1);
+}
+
+static void vm_compile_unary(VmCompiler* c, Node* node, VmOp op) {
+    vm_compile_node(c, node->children[0]);
+    vm_emit(c, op, 0, 0, 0);
+}
+
+// An instruction that doesn't stand for any node (not counted by profiles)
+static int vm_emit_extra(VmCompiler* c, VmOp op, int aux, int arg, int stack_delta) {
+    uint8_t src = c->src;
+    int own = c->own;
+    c->src = VM_SRC_NONE;
+    int at = vm_emit(c, op, aux, arg, stack_delta);
+    c->src = src;
+    c->own = own;
+    return at;
+}
+
+static void vm_compile_op(VmCompiler* c, Node* node);
+
+static void vm_compile_node(VmCompiler* c, Node* node) {
+    if (!node) {
+        int own = c->own;
+        vm_emit(c, VM_CONST, 0, 0, 1);
+        c->own = own;
+        return;
+    }
+    CseClass* k = NULL;
+    if (c->cse) {
+        CseNode* e = cse_node(c->cse, node);
+        if (e->node && e->cls >= 0 && c->cse->classes[e->cls].reg >= 0) k = &c->cse->classes[e->cls];
+    }
+    if (!k) {
+        vm_compile_op(c, node);
+        return;
+    }
+
+    if (k->computed) {
+        vm_emit_extra(c, VM_REG_LOAD, 0, k->reg, 1);
+    } else if (!k->seen && !c->conditional) {
+        vm_compile_op(c, node);
+        vm_emit_extra(c, VM_REG_STORE, 0, k->reg, 0);
+    } else {
+        // The jump path pushes the register, the fall-through computes it
+        int probe = vm_emit_extra(c, VM_REG_TRY, k->reg, 0, 0);
+        c->conditional++;
+        vm_compile_op(c, node);
+        c->conditional--;
+        vm_emit_extra(c, VM_REG_STORE, 0, k->reg, 0);
+        c->instrs[probe].arg = c->length;
+    }
+    k->seen++;
+    if (!c->conditional) k->computed = 1;
+}
+
+static void vm_compile_op(VmCompiler* c, Node* node) {
+    // The first instruction a node emits after its children (the operation
+    // itself, the branch of an IF, CALL_BEGIN...) is the one that counts it
+    uint8_t parent_src = c->src;
+    int parent_own = c->own;
+    c->src = (uint8_t)node->op;
+    c->own = -1;
+
+    switch (node->op) {
+        case OP_ADD: vm_compile_binary(c, node, VM_ADD); break;
+        case OP_SUB: vm_compile_binary(c, node, VM_SUB); break;
+        case OP_MUL: vm_compile_binary(c, node, VM_MUL); break;
+        case OP_DIV: vm_compile_binary(c, node, VM_DIV); break;
+        case OP_MOD: vm_compile_binary(c, node, VM_MOD); break;
+        case OP_AND: vm_compile_binary(c, node, VM_AND); break;
+        case OP_OR: vm_compile_binary(c, node, VM_OR); break;
+        case OP_XOR: vm_compile_binary(c, node, VM_XOR); break;
+        case OP_NOT: vm_compile_unary(c, node, VM_NOT); break;
+        case OP_EQ: vm_compile_binary(c, node, VM_EQ); break;
+        case OP_LT: vm_compile_binary(c, node, VM_LT); break;
+        case OP_LTE: vm_compile_binary(c, node, VM_LTE); break;
+        case OP_ABS: vm_compile_unary(c, node, VM_ABS); break;
+        case OP_NEG: vm_compile_unary(c, node, VM_NEG); break;
+        case OP_MAX: vm_compile_binary(c, node, VM_MAX); break;
+        case OP_MIN: vm_compile_binary(c, node, VM_MIN); break;
+        case OP_GT: vm_compile_binary(c, node, VM_GT); break;
+        case OP_SIN: vm_compile_unary(c, node, VM_SIN); break;
+        case OP_TANH: vm_compile_unary(c, node, VM_TANH); break;
+        case OP_STEP: vm_compile_unary(c, node, VM_STEP); break;
+        case OP_IDENT:
+            // Identity needs no instruction
+            vm_compile_node(c, node->children[0]);
+            break;
+        case OP_CONST:
+            vm_emit(c, VM_CONST, 0, node->value, 1);
+            break;
+        case OP_INPUT:
+            if (node->value >= 0 && node->value < MAX_INPUTS) {
+                vm_emit(c, VM_INPUT, 0, node->value, 1);
+            } else {
+                vm_emit(c, VM_CONST, 0, 0, 1);
+            }
+            break;
+        case OP_OUTPUT:
+            vm_compile_node(c, node->children[0]);
+            vm_emit(c, VM_OUTPUT, 0, 0, 0);
+            break;
+        case OP_IF_GT: {
+            vm_compile_node(c, node->children[0]);
+            vm_compile_node(c, node->children[1]);
+            int jle = vm_emit(c, VM_JLE, 0, 0, -2);
+            int base = c->depth;
+            c->conditional++;
+            vm_compile_node(c, node->children[2]);
+            int jmp = vm_emit(c, VM_JMP, 0, 0, 0);
+            c->depth = base;
+            c->instrs[jle].arg = c->length;
+            vm_compile_node(c, node->children[3]);
+            c->conditional--;
+            c->instrs[jmp].arg = c->length;
+            break;
+        }
+        case OP_IF: {
+            vm_compile_node(c, node->children[0]);
+            int jz = vm_emit(c, VM_JZ, 0, 0, -1);
+            int base = c->depth;
+            c->conditional++;
+            vm_compile_node(c, node->children[1]);
+            int jmp = vm_emit(c, VM_JMP, 0, 0, 0);
+            c->depth = base;
+            c->instrs[jz].arg = c->length;
+            vm_compile_node(c, node->children[2]);
+            c->conditional--;
+            c->instrs[jmp].arg = c->length;
+            break;
+        }
+        case OP_SEQ:
+            vm_compile_node(c, node->children[0]);
+            vm_emit(c, VM_POP, 0, 0, -1);
+            vm_compile_node(c, node->children[1]);
+            vm_emit(c, VM_VOID, 0, 0, 0);
+            break;
+        case OP_LIBRARY:
+            vm_emit(c, VM_LIB, 0, node->value, 1);
+            break;
+        case OP_MEM_READ:
+            if (node->value >= 0 && node->value < MAX_MEMORY) {
+                vm_emit(c, VM_MEM_READ, 0, node->value, 1);
+            } else {
+                vm_emit(c, VM_CONST, 0, 0, 1);
+            }
+            break;
+        case OP_MEM_WRITE:
+            vm_compile_node(c, node->children[0]);
+            if (node->value >= 0 && node->value < MAX_MEMORY) {
+                vm_emit(c, VM_MEM_WRITE, 0, node->value, 0);
+            } else {
+                vm_emit(c, VM_VOID, 0, 0, 0);
+            }
+            break;
+        case OP_FUNC_CALL: {
+            // The frame is opened before the arguments so a failed library
+            // lookup skips them entirely, exactly like execute_node. CALL_BEGIN
+            // points at its CALL, which carries the library index.
+            int begin = vm_emit(c, VM_CALL_BEGIN, node->num_children, 0, 0);
+            c->frames++;
+            if (c->frames > c->max_frames) c->max_frames = c->frames;
+
+            int guards[MAX_CHILDREN];
+            c->conditional++;
+            for (int i = 0; i < node->num_children; i++) {
+                guards[i] = vm_emit(c, VM_ARG_GUARD, i, 0, 0);
+                vm_compile_node(c, node->children[i]);
+                vm_emit(c, VM_PUSH_ARG, 0, 0, -1);
+            }
+            c->conditional--;
+            int call = vm_emit(c, VM_CALL, 0, node->value, 1);
+            for (int i = 0; i < node->num_children; i++) {
+                c->instrs[guards[i]].arg = call;
+            }
+            c->instrs[begin].arg = call;
+            c->frames--;
+            break;
+        }
+        case OP_PARAM:
+            vm_emit(c, VM_PARAM, 0, node->value, 1);
+            break;
+        default:
+            vm_emit(c, VM_CONST, 0, 0, 1);
+            break;
+    }
+
+    if (c->own >= 0) c->instrs[c->own].src |= VM_SRC_COUNTED;
+    c->src = parent_src;
+    c->own = parent_own;
+}
+
+Bytecode* bytecode_compile(Node* root) {
+    VmCompiler c = {0};
+    c.src = VM_SRC_NONE;
+    c.own = -1;
+    Cse cse;
+    int num_regs = cse_build(&cse, root);
+    if (num_regs) c.cse = &cse;
+    vm_compile_node(&c, root);
+    vm_emit(&c, VM_RET, 0, 0, 0);
+    cse_free(&cse);
+
+    Bytecode* code = malloc(sizeof(Bytecode) + sizeof(VmInstr) * c.length);
+    code->length = c.length;
+    code->max_stack = c.max_stack;
+    code->max_frames = c.max_frames;
+    code->num_regs = num_regs;
+    memcpy(code->instrs, c.instrs, sizeof(VmInstr) * c.length);
+    free(c.instrs);
+    return code;
+}
+
+Bytecode* bytecode_copy(const Bytecode* code) {
+    if (!code) return NULL;
+    size_t bytes = sizeof(Bytecode) + sizeof(VmInstr) * code->length;
+    Bytecode* copy = malloc(bytes);
+    memcpy(copy, code, bytes);
+    return copy;
+}
+
+void bytecode_destroy(Bytecode* code) {
+    free(code);
+}
+
+int bytecode_length(const Bytecode* code) {
+    return code ? code->length : 0;
+}
+
+int bytecode_registers(const Bytecode* code) {
+    return code ? code->num_regs : 0;
+}
+
+#ifdef GP_PROFILE
+// Called at every VM dispatch: counts the node the instruction stands for
+// and, with cycles, charges the time since the previous dispatch (on this
+// thread, so nested library runs are not counted twice) to the previous one
+static inline void profile_vm(const VmInstr* ip) {
+    OpProfile* p = profile_self();
+    if (ip->src & VM_SRC_COUNTED) profile_add(&p->count[ip->src & VM_SRC_NONE], 1);
+#ifdef GP_PROFILE_CYCLES
+    uint64_t now = profile_ticks();
+    if (tls_profile_src != VM_SRC_NONE) profile_add(&p->cycles[tls_profile_src], now - tls_profile_tick);
+    tls_profile_tick = now;
+    tls_profile_src = ip->src & VM_SRC_NONE;
+#endif
+}
+
+#define PROFILE_VM(ip) profile_vm(ip)
+#else
+#define PROFILE_VM(ip)
+#endif
+
+typedef struct {
+    int old_stack_ptr;
+    int old_frame_base;
+    int num_args;       // Arguments actually evaluated for this call
+} VmFrame;
+
+#define VM_ARGS_CAPACITY ((int)(sizeof(((Context*)0)->args) / sizeof(int)))
+
+static int vm_run(const Bytecode* code, Context* ctx, Population* pop, int call_depth);
+
+static int vm_call_library(Population* pop, int idx, Context* ctx, int call_depth) {
+    LibraryEntry* entry = &pop->library[idx];
+    if (call_depth >= MAX_CALL_DEPTH) return 0;
+    if (entry->code) return vm_run(entry->code, ctx, pop, call_depth + 1);
+    return execute_node(entry->tree, ctx, pop);
+}
+
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+static int vm_run(const Bytecode* code, Context* ctx, Population* pop, int call_depth) {
+    int stack[code->max_stack + 1];
+    VmFrame frames[code->max_frames + 1];
+    int regs[code->num_regs + 1];
+    uint64_t regs_set = 0;        // Bit r: regs[r] holds this run's value
+    int* sp = stack;              // Next free slot
+    VmFrame* fp = frames;         // Next free frame
+    const VmInstr* ip = code->instrs;
+    const VmInstr* base = code->instrs;
+    uint64_t steps = 0;           // Added to the thread's node count on return
+
+#ifdef VM_COMPUTED_GOTO
+    static const void* targets[VM_OP_COUNT] = {
+        [VM_CONST] = &&L_VM_CONST, [VM_INPUT] = &&L_VM_INPUT,
+        [VM_MEM_READ] = &&L_VM_MEM_READ, [VM_PARAM] = &&L_VM_PARAM,
+        [VM_ADD] = &&L_VM_ADD, [VM_SUB] = &&L_VM_SUB, [VM_MUL] = &&L_VM_MUL,
+        [VM_DIV] = &&L_VM_DIV, [VM_MOD] = &&L_VM_MOD, [VM_AND] = &&L_VM_AND,
+        [VM_OR] = &&L_VM_OR, [VM_XOR] = &&L_VM_XOR, [VM_NOT] = &&L_VM_NOT,
+        [VM_EQ] = &&L_VM_EQ, [VM_LT] = &&L_VM_LT, [VM_LTE] = &&L_VM_LTE,
+        [VM_ABS] = &&L_VM_ABS, [VM_NEG] = &&L_VM_NEG, [VM_MAX] = &&L_VM_MAX,
+        [VM_MIN] = &&L_VM_MIN, [VM_GT] = &&L_VM_GT, [VM_SIN] = &&L_VM_SIN,
+        [VM_TANH] = &&L_VM_TANH, [VM_STEP] = &&L_VM_STEP,
+        [VM_OUTPUT] = &&L_VM_OUTPUT, [VM_MEM_WRITE] = &&L_VM_MEM_WRITE,
+        [VM_POP] = &&L_VM_POP, [VM_VOID] = &&L_VM_VOID, [VM_JMP] = &&L_VM_JMP,
+        [VM_JZ] = &&L_VM_JZ, [VM_JLE] = &&L_VM_JLE, [VM_LIB] = &&L_VM_LIB,
+        [VM_CALL_BEGIN] = &&L_VM_CALL_BEGIN, [VM_ARG_GUARD] = &&L_VM_ARG_GUARD,
+        [VM_PUSH_ARG] = &&L_VM_PUSH_ARG, [VM_CALL] = &&L_VM_CALL,
+        [VM_RET] = &&L_VM_RET, [VM_REG_LOAD] = &&L_VM_REG_LOAD,
+        [VM_REG_TRY] = &&L_VM_REG_TRY, [VM_REG_STORE] = &&L_VM_REG_STORE,
+    };
+#define VM_TARGET(op) L_##op:
+#define VM_NEXT() { steps += GP_NODE_COUNT; PROFILE_VM(ip); goto *targets[ip->op]; }
+    VM_NEXT();
+#else
+#define VM_TARGET(op) case op:
+#define VM_NEXT() { steps += GP_NODE_COUNT; PROFILE_VM(ip); continue; }
+    PROFILE_VM(ip);
+    for (;;) switch (ip->op) {
+#endif
+
+#define VM_BINARY(op, expr) \
+    VM_TARGET(op) { int b = *--sp; int a = sp[-1]; sp[-1] = (expr); ip++; VM_NEXT(); }
+#define VM_UNARY(op, expr) \
+    VM_TARGET(op) { int a = sp[-1]; sp[-1] = (expr); ip++; VM_NEXT(); }
+
+    VM_TARGET(VM_CONST) {
+        *sp++ = ip->arg;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_INPUT) {
+        *sp++ = (ip->arg < ctx->num_inputs) ? ctx->inputs[ip->arg] : 0;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_MEM_READ) {
+        *sp++ = ctx->memory[ip->arg];
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_PARAM) {
+        int arg_pos = ctx->arg_frame_base + ip->arg;
+        *sp++ = (arg_pos >= 0 && arg_pos < ctx->arg_stack_ptr && arg_pos < VM_ARGS_CAPACITY)
+                ? ctx->args[arg_pos] : 0;
+        ip++;
+        VM_NEXT();
+    }
+
+    VM_BINARY(VM_ADD, a + b)
+    VM_BINARY(VM_SUB, a - b)
+    VM_BINARY(VM_MUL, a * b)
+    VM_BINARY(VM_DIV, (b != 0) ? (a / b) : 0)
+    VM_BINARY(VM_MOD, (b != 0) ? (a % b) : 0)
+    VM_BINARY(VM_AND, a & b)
+    VM_BINARY(VM_OR, a | b)
+    VM_BINARY(VM_XOR, a ^ b)
+    VM_UNARY(VM_NOT, ~a)
+    VM_BINARY(VM_EQ, (a == b) ? 1 : 0)
+    VM_BINARY(VM_LT, (a < b) ? 1 : 0)
+    VM_BINARY(VM_LTE, (a <= b) ? 1 : 0)
+    VM_UNARY(VM_ABS, (a < 0) ? -a : a)
+    VM_UNARY(VM_NEG, -a)
+    VM_BINARY(VM_MAX, (a > b) ? a : b)
+    VM_BINARY(VM_MIN, (a < b) ? a : b)
+    VM_BINARY(VM_GT, (a > b) ? 1 : 0)
+    VM_UNARY(VM_SIN, (int)(sin((double)a / 100.0) * 100.0))
+    VM_UNARY(VM_TANH, (int)(tanh((double)a / 100.0) * 100.0))
+    VM_UNARY(VM_STEP, (a > 0) ? 1 : 0)
+
+    VM_TARGET(VM_OUTPUT) {
+        if (ctx->num_outputs < MAX_OUTPUTS) {
+            ctx->outputs[ctx->num_outputs++] = sp[-1];
+        }
+        sp[-1] = 0;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_MEM_WRITE) {
+        ctx->memory[ip->arg] = sp[-1];
+        sp[-1] = 0;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_POP) {
+        sp--;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_VOID) {
+        sp[-1] = 0;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_JMP) {
+        ip = base + ip->arg;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_JZ) {
+        int cond = *--sp;
+        ip = (cond == 0) ? base + ip->arg : ip + 1;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_JLE) {
+        int b = *--sp;
+        int a = *--sp;
+        ip = (a > b) ? ip + 1 : base + ip->arg;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_LIB) {
+        int idx = ip->arg;
+        *sp++ = (pop && idx >= 0 && idx < pop->library_size)
+                ? vm_call_library(pop, idx, ctx, call_depth) : 0;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_CALL_BEGIN) {
+        int idx = base[ip->arg].arg;
+        if (!pop || idx < 0 || idx >= pop->library_size) {
+            *sp++ = 0;
+            ip = base + ip->arg + 1;
+            VM_NEXT();
+        }
+        int num_params = pop->library[idx].num_params;
+        fp->old_stack_ptr = ctx->arg_stack_ptr;
+        fp->old_frame_base = ctx->arg_frame_base;
+        fp->num_args = (num_params < ip->aux) ? num_params : ip->aux;
+        fp++;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_ARG_GUARD) {
+        ip = (ip->aux < fp[-1].num_args) ? ip + 1 : base + ip->arg;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_PUSH_ARG) {
+        int val = *--sp;
+        if (ctx->arg_stack_ptr < VM_ARGS_CAPACITY) {
+            ctx->args[ctx->arg_stack_ptr] = val;
+        }
+        ctx->arg_stack_ptr++;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_CALL) {
+        VmFrame* frame = --fp;
+        ctx->arg_frame_base = frame->old_stack_ptr;
+        int result = vm_call_library(pop, ip->arg, ctx, call_depth);
+        ctx->arg_stack_ptr = frame->old_stack_ptr;
+        ctx->arg_frame_base = frame->old_frame_base;
+        *sp++ = result;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_REG_LOAD) {
+        *sp++ = regs[ip->arg];
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_REG_TRY) {
+        if (regs_set & (1ull << ip->aux)) {
+            *sp++ = regs[ip->aux];
+            ip = base + ip->arg;
+        } else {
+            ip++;
+        }
+        VM_NEXT();
+    }
+    VM_TARGET(VM_REG_STORE) {
+        regs[ip->arg] = sp[-1];
+        regs_set |= 1ull << ip->arg;
+        ip++;
+        VM_NEXT();
+    }
+    VM_TARGET(VM_RET) {
+        COUNT_NODES(steps + 1);
+        return sp[-1];
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    default:
+        COUNT_NODES(steps + 1);
+        return 0;
+    }
+#endif
+
+#undef VM_BINARY
+#undef VM_UNARY
+#undef VM_TARGET
+#undef VM_NEXT
+}
+
+int execute_bytecode(const Bytecode* code, Context* ctx, Population* pop) {
+    if (!code) return 0;
+    return vm_run(code, ctx, pop, 0);
+}
+
+void execute_program(Program* prog, Context* ctx, Population* pop) {
+    ctx->num_outputs = 0;
+    if (prog && prog->code) {
+        vm_run(prog->code, ctx, pop, 0);
+    } else if (prog && prog->root) {
+        execute_node(prog->root, ctx, pop);
+    }
+}
+
+// Thread pool
+struct ThreadPool {
+    int num_threads;             // Workers including the caller
+    pthread_t* threads;          // num_threads - 1 helpers
+    pthread_barrier_t start;
+    pthread_barrier_t done;
+    PoolTask task;
+    void* arg;
+    int shutdown;
+    int pinned;                  // Caller pinned too; restore its mask on destroy
+    pthread_t caller;
+    cpu_set_t caller_mask;
+};
+
+typedef struct {
+    ThreadPool* pool;
+    int worker;
+} PoolWorker;
+
+static void* pool_worker_main(void* arg) {
+    PoolWorker* self = (PoolWorker*)arg;
+    ThreadPool* pool = self->pool;
+    int worker = self->worker;
+    free(self);
+
+    for (;;) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->shutdown) break;
+        pool->task(pool->arg, worker, pool->num_threads);
+        pthread_barrier_wait(&pool->done);
+    }
+    return NULL;
+}
+
+// CPUs this process may use: affinity mask, capped by a cgroup CPU quota
+int gp_available_cpus(void) {
+    int cpus = 1;
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        cpus = CPU_COUNT(&set);
+    } else {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (online > 0) cpus = (int)online;
+    }
+
+    long quota = -1;
+    long period = 0;
+    FILE* f = fopen("/sys/fs/cgroup/cpu.max", "r");  // cgroup v2
+    if (f) {
+        char max[32];
+        if (fscanf(f, "%31s %ld", max, &period) == 2 && strcmp(max, "max") != 0) {
+            quota = atol(max);
+        }
+        fclose(f);
+    } else {
+        f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");  // cgroup v1
+        if (f) {
+            if (fscanf(f, "%ld", &quota) != 1) quota = -1;
+            fclose(f);
+        }
+        f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+        if (f) {
+            if (fscanf(f, "%ld", &period) != 1) period = 0;
+            fclose(f);
+        }
+    }
+    if (quota > 0 && period > 0) {
+        int limit = (int)((quota + period - 1) / period);
+        if (limit < cpus) cpus = limit;
+    }
+
+    return cpus > 0 ? cpus : 1;
+}
+
+// Pin a thread to the n-th CPU of allowed
+static void pin_to_allowed_cpu(pthread_t thread, int n, const cpu_set_t* allowed) {
+    int count = CPU_COUNT(allowed);
+    if (count == 0) return;
+    n %= count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, allowed) && n-- == 0) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(thread, sizeof(one), &one);
+            return;
+        }
+    }
+}
+
+ThreadPool* pool_create(int num_threads, int pin_threads) {
+    if (num_threads < 1) num_threads = 1;
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    pool->num_threads = num_threads;
+    if (num_threads == 1) return pool;
+
+    // The caller is worker 0, so pinning covers it as well; its own mask is
+    // put back when the pool goes away
+    if (pin_threads) {
+        pool->caller = pthread_self();
+        pool->pinned = pthread_getaffinity_np(pool->caller, sizeof(cpu_set_t), &pool->caller_mask) == 0;
+        pin_threads = pool->pinned;
+    }
+
+    pthread_barrier_init(&pool->start, NULL, num_threads);
+    pthread_barrier_init(&pool->done, NULL, num_threads);
+    pool->threads = calloc(num_threads - 1, sizeof(pthread_t));
+    for (int i = 1; i < num_threads; i++) {
+        PoolWorker* w = malloc(sizeof(PoolWorker));
+        w->pool = pool;
+        w->worker = i;
+        pthread_create(&pool->threads[i - 1], NULL, pool_worker_main, w);
+        if (pin_threads) pin_to_allowed_cpu(pool->threads[i - 1], i, &pool->caller_mask);
+    }
+    if (pin_threads) pin_to_allowed_cpu(pool->caller, 0, &pool->caller_mask);
+    return pool;
+}
+
+void pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+    if (pool->num_threads > 1) {
+        pool->shutdown = 1;
+        pthread_barrier_wait(&pool->start);
+        for (int i = 0; i < pool->num_threads - 1; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+        pthread_barrier_destroy(&pool->start);
+        pthread_barrier_destroy(&pool->done);
+        free(pool->threads);
+        if (pool->pinned) pthread_setaffinity_np(pool->caller, sizeof(cpu_set_t), &pool->caller_mask);
+    }
+    free(pool);
+}
+
+void pool_run(ThreadPool* pool, PoolTask task, void* arg) {
+    if (pool->num_threads == 1) {
+        task(arg, 0, 1);
+        return;
+    }
+    pool->task = task;
+    pool->arg = arg;
+    pthread_barrier_wait(&pool->start);
+    task(arg, 0, pool->num_threads);
+    pthread_barrier_wait(&pool->done);
+}
+
+int pool_size(ThreadPool* pool) {
+    return pool ? pool->num_threads : 1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Lock wait accounting (GenerationStats.lock_wait etc.): an uncontended
+// acquire is a single trylock, only a thread that has to wait reads the clock
+static void lock_wait_add(uint64_t* wait_ns, uint64_t* contentions, double start) {
+    __atomic_fetch_add(wait_ns, (uint64_t)((now_seconds() - start) * 1e9), __ATOMIC_RELAXED);
+    __atomic_fetch_add(contentions, 1, __ATOMIC_RELAXED);
+}
+
+static void mutex_lock_counted(pthread_mutex_t* mutex, uint64_t* wait_ns, uint64_t* contentions) {
+    if (pthread_mutex_trylock(mutex) == 0) return;
+    double start = now_seconds();
+    pthread_mutex_lock(mutex);
+    lock_wait_add(wait_ns, contentions, start);
+}
+
+// Fitness cache: a hash table split into shards, each behind its own
+// mutex. Keys mix the program hash with a tag (library version, plus the
+// generation for stochastic tasks). A shard is cleared when it gets half
+// full, so stale entries never need explicit eviction.
+#define CACHE_SHARDS 64
+
+typedef struct {
+    uint64_t key;       // 0 = empty
+    float fitness;
+} CacheSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int count;
+    CacheSlot* slots;
+} CacheShard;
+
+struct FitnessCache {
+    int shard_mask;     // Slots per shard - 1
+    uint64_t wait_ns;   // Time spent waiting for shard locks
+    uint64_t contentions;
+    CacheShard shards[CACHE_SHARDS];
+};
+
+static FitnessCache* fitness_cache_create(int capacity) {
+    FitnessCache* cache = calloc(1, sizeof(FitnessCache));
+    int slots = 64;
+    while (slots * CACHE_SHARDS < capacity * 2) slots *= 2;
+    cache->shard_mask = slots - 1;
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_init(&cache->shards[i].lock, NULL);
+        cache->shards[i].slots = calloc(slots, sizeof(CacheSlot));
+    }
+    return cache;
+}
+
+static void fitness_cache_destroy(FitnessCache* cache) {
+    if (!cache) return;
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        free(cache->shards[i].slots);
+    }
+    free(cache);
+}
+
+static int fitness_cache_lookup(FitnessCache* cache, uint64_t key, float* fitness) {
+    CacheShard* shard = &cache->shards[key >> 58];
+    int found = 0;
+    mutex_lock_counted(&shard->lock, &cache->wait_ns, &cache->contentions);
+    for (int i = (int)(key & cache->shard_mask);; i = (i + 1) & cache->shard_mask) {
+        if (shard->slots[i].key == 0) break;
+        if (shard->slots[i].key == key) {
+            *fitness = shard->slots[i].fitness;
+            found = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return found;
+}
+
+static void fitness_cache_insert(FitnessCache* cache, uint64_t key, float fitness) {
+    CacheShard* shard = &cache->shards[key >> 58];
+    mutex_lock_counted(&shard->lock, &cache->wait_ns, &cache->contentions);
+    if (shard->count * 2 >= cache->shard_mask + 1) {
+        memset(shard->slots, 0, sizeof(CacheSlot) * (cache->shard_mask + 1));
+        shard->count = 0;
+    }
+    int i = (int)(key & cache->shard_mask);
+    while (shard->slots[i].key != 0 && shard->slots[i].key != key) {
+        i = (i + 1) & cache->shard_mask;
+    }
+    if (shard->slots[i].key == 0) shard->count++;
+    shard->slots[i].key = key;
+    shard->slots[i].fitness = fitness;
+    pthread_mutex_unlock(&shard->lock);
+}
+
+static uint64_t fitness_cache_key(uint64_t hash, uint64_t tag) {
+    uint64_t key = rng_derive(hash, tag, 0);
+    return key ? key : 1;
+}
+
+// Population
+// Deferred library learning for pipelined generations (see library_snapshot_take)
+static LibrarySnapshot* library_snapshot_take(Population* pop);
+static void library_snapshot_learn(LibrarySnapshot* snap);
+static void library_snapshot_install(Population* pop, LibrarySnapshot* snap);
+static void library_snapshot_destroy(LibrarySnapshot* snap);
+
+void pop_config_default(PopConfig* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->pop_size = POP_SIZE;
+    cfg->tournament_size = TOURNAMENT_SIZE;
+    cfg->elite_size = ELITE_SIZE;
+    const char* env = getenv("GP_THREADS");
+    if (env) cfg->num_threads = atoi(env);
+    cfg->eval_batch = 4;
+    cfg->eval_largest_first = 1;
+    cfg->fitness_cache = 1;
+    cfg->pipeline_threshold = 0.9f;
+    env = getenv("GP_SEED");
+    if (env) cfg->seed = strtoull(env, NULL, 0);
+    cfg->stats_json = getenv("GP_STATS_JSON");
+    env = getenv("GP_SIMPLIFY");
+    if (env && simplify_mode_parse(env) >= 0) cfg->simplify = simplify_mode_parse(env);
+    env = getenv("GP_SHARE_SUBTREES");
+    if (env) cfg->share_subtrees = atoi(env);
+}
+
+Population* pop_create() {
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    return pop_create_config(&cfg);
+}
+
+// Each worker opens counters on its own thread; phase_end reads them all
+static void perf_open_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    Population* pop = (Population*)arg;
+    pop->perf[worker] = perf_open();
+}
+
+Population* pop_create_config(const PopConfig* cfg) {
+    Population* pop = calloc(1, sizeof(Population));
+    pthread_mutex_init(&pop->lock, NULL);
+    pop->pop_size = cfg->pop_size > 0 ? cfg->pop_size : POP_SIZE;
+    pop->tournament_size = cfg->tournament_size > 0 ? cfg->tournament_size : TOURNAMENT_SIZE;
+    pop->elite_size = cfg->elite_size >= 0 ? cfg->elite_size : ELITE_SIZE;
+    if (pop->elite_size > pop->pop_size) pop->elite_size = pop->pop_size;
+    pop->programs = calloc(pop->pop_size, sizeof(Program*));
+    pop->next_programs = calloc(pop->pop_size, sizeof(Program*));
+    pop->ranking = calloc(pop->pop_size, sizeof(int));
+    pop->eval_order = calloc(pop->pop_size, sizeof(int));
+    pop->num_threads = cfg->num_threads > 0 ? cfg->num_threads : gp_available_cpus();
+    if (pop->num_threads > GP_MAX_THREADS) pop->num_threads = GP_MAX_THREADS;
+    pop->eval_batch = cfg->eval_batch;
+    pop->eval_largest_first = cfg->eval_largest_first;
+    pop->deterministic_fitness = cfg->deterministic_fitness;
+    pop->pipeline = cfg->pipeline;
+    pop->pipeline_threshold = cfg->pipeline_threshold;
+    pop->simplify = cfg->simplify;
+    pop->share_subtrees = cfg->share_subtrees;
+    pop->boolean_ops = cfg->boolean_ops;
+    pop->num_input_ranges = cfg->input_ranges ? cfg->num_input_ranges : 0;
+    if (pop->num_input_ranges > MAX_INPUTS) pop->num_input_ranges = MAX_INPUTS;
+    for (int i = 0; i < pop->num_input_ranges; i++) pop->input_ranges[i] = cfg->input_ranges[i];
+    if (pop->pipeline) pop->scored = calloc(pop->pop_size, sizeof(uint8_t));
+    if (cfg->fitness_cache) pop->cache = fitness_cache_create(pop->pop_size);
+    pop->seed = cfg->seed;
+    if (!pop->seed) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        pop->seed = rng_derive((uint64_t)ts.tv_sec, (uint64_t)ts.tv_nsec, (uint64_t)getpid());
+    }
+    pop->pool = pool_create(pop->num_threads, cfg->pin_threads);
+    pop->best_fitness = -INFINITY;
+    for (int t = 0; t < pop->num_threads; t++) {
+        pop->arenas[0][t] = node_arena_create();
+        pop->arenas[1][t] = node_arena_create();
+    }
+    pop->use_arena = 1;
+    if (cfg->perf_counters) pool_run(pop->pool, perf_open_task, pop);
+    if (cfg->stats_json && cfg->stats_json[0]) {
+        if (strcmp(cfg->stats_json, "-") == 0) {
+            pop->stats_json = stdout;
+        } else {
+            pop->stats_json = fopen(cfg->stats_json, "a");
+            pop->stats_json_owned = pop->stats_json != NULL;
+            if (!pop->stats_json) perror(cfg->stats_json);
+        }
+    }
+    return pop;
+}
+
+void pop_destroy(Population* pop) {
+    if (!pop) return;
+    for (int i = 0; i < pop->pop_size; i++) {
+        prog_destroy(pop->programs[i]);
+    }
+    free(pop->programs);
+    free(pop->next_programs);
+    free(pop->ranking);
+    free(pop->eval_order);
+    free(pop->slot_locks);
+    free(pop->slot_fitness);
+    free(pop->scored);
+    library_snapshot_destroy(pop->library_snapshot);
+    for (int i = 0; i < pop->library_size; i++) {
+        node_destroy(pop->library[i].tree);
+        bytecode_destroy(pop->library[i].code);
+    }
+    prog_destroy(pop->best);
+    fitness_cache_destroy(pop->cache);
+    for (int t = 0; t < pop->num_threads; t++) {
+        node_arena_destroy(pop->arenas[0][t]);
+        node_arena_destroy(pop->arenas[1][t]);
+    }
+    pool_destroy(pop->pool);
+    for (int t = 0; t < pop->num_threads; t++) perf_close(pop->perf[t]);
+    if (pop->stats_json_owned) fclose(pop->stats_json);
+    pthread_mutex_destroy(&pop->lock);
+    free(pop);
+}
+
+// Editors take a tree that may hold shared subtrees and return the node to
+// put in its place. Private nodes are changed in place; a shared one is
+// copied first (node_unshare), and node_set_child releases whatever the
+// slot held if the editor handed back something else.
+static Node* node_set_child(Node* node, int i, Node* child) {
+    Node* old = node->children[i];
+    if (child == old) return node;
+    node = node_unshare(node);
+    node_destroy(old);
+    node->children[i] = child;
+    return node;
+}
+
+// node_set_child for a root
+static Node* node_set_root(Node* old, Node* root) {
+    if (root != old) node_destroy(old);
+    return root;
+}
+
+// Mutation: replace a random subtree
+static Node* mutate_tree(Node* node, int depth, int num_inputs, int boolean) {
+    if (!node) return NULL;
+
+    // 20% chance to replace this subtree
+    if (random_int(5) == 0) {
+        return create_random_tree(depth, MAX_DEPTH, random_int(2) == 0 ? TYPE_INT : TYPE_VOID, num_inputs,
+                                  boolean);
+    }
+
+    for (int i = 0; i < node->num_children; i++) {
+        node = node_set_child(node, i, mutate_tree(node->children[i], depth + 1, num_inputs, boolean));
+    }
+
+    return node;
+}
+
+// Inject library calls into tree
+static Node* inject_library_calls(Node* node, Population* pop, int depth) {
+    if (!node || !pop || pop->library_size == 0) return node;
+    if (depth > MAX_DEPTH) return node;
+
+    // Get node's return type
+    OpInfo* info = get_op_info(node->op);
+    if (!info) return node;
+
+    // 5% chance to replace this node with a library call
+    // Only replace INT-returning nodes (library entries return INT)
+    if (random_int(20) == 0 && info->return_type == TYPE_INT) {
+        int lib_idx = random_int(pop->library_size);
+        LibraryEntry* lib = &pop->library[lib_idx];
+        node = node_unshare(node);
+
+        if (lib->num_params > 0) {
+            // Create parameterized function call
+            node->op = OP_FUNC_CALL;
+            node->value = lib_idx;
+
+            // Destroy old children
+            for (int i = 0; i < node->num_children; i++) {
+                node_destroy(node->children[i]);
+            }
+
+            // Create random argument expressions
+            node->num_children = lib->num_params;
+            for (int i = 0; i < lib->num_params; i++) {
+                node->children[i] = create_random_tree(depth + 1, MAX_DEPTH, TYPE_INT, pop->num_inputs,
+                                                       pop->boolean_ops);
+            }
+        } else {
+            // Non-parameterized library call
+            node->op = OP_LIBRARY;
+            node->value = lib_idx;
+            // Destroy children since library is a terminal
+            for (int i = 0; i < node->num_children; i++) {
+                node_destroy(node->children[i]);
+            }
+            node->num_children = 0;
+        }
+
+        __atomic_fetch_add(&lib->uses, 1, __ATOMIC_RELAXED);  // Breeding runs in parallel
+        return node;
+    }
+
+    // Recursively process children
+    for (int i = 0; i < node->num_children; i++) {
+        node = node_set_child(node, i, inject_library_calls(node->children[i], pop, depth + 1));
+    }
+    return node;
+}
+
+Program* evolve_mutate(Program* parent, Population* pop) {
+    Program* child = calloc(1, sizeof(Program));
+    int num_inputs = pop ? pop->num_inputs : MAX_INPUTS;
+    Node* root = node_share(parent->root);
+    child->root = node_set_root(root, mutate_tree(root, 0, num_inputs, pop && pop->boolean_ops));
+
+    // Possibly inject library calls
+    if (pop && pop->library_size > 0 && random_int(3) == 0) {
+        child->root = node_set_root(child->root, inject_library_calls(child->root, pop, 0));
+    }
+
+    child->depth = node_depth(child->root);
+    child->size = node_size(child->root);
+    child->fitness = -INFINITY;
+    prog_compile(child);
+    return child;
+}
+
+// Crossover: swap random subtrees
+static Node* get_random_node(Node* node, int* count) {
+    if (!node) return NULL;
+    if (random_int(++(*count)) == 0) {
+        return node;
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        Node* result = get_random_node(node->children[i], count);
+        if (result) return result;
+    }
+    return node;
+}
+
+static Node* crossover_donor(Node* donor) {
+    int count = 0;
+    return node_share(get_random_node(donor, &count));
+}
+
+// Copy of node with the node get_random_node's walk would pick replaced by
+// a random subtree of donor. Draws happen in the same order as picking the
+// point in a copy of node and then the donor. Only the path down to the
+// point is new; the subtrees beside it are node_share'd.
+static Node* crossover_copy(Node* node, int* count, Node* donor) {
+    if (!node) return NULL;
+    if (random_int(++(*count)) == 0) return crossover_donor(donor);
+    for (int i = 0; i < node->num_children; i++) {
+        Node* replaced = crossover_copy(node->children[i], count, donor);
+        if (!replaced) continue;
+        Node* copy = node_create(node->op, node->value);
+        copy->num_children = node->num_children;
+        for (int j = 0; j < node->num_children; j++) {
+            copy->children[j] = j == i ? replaced : node_share(node->children[j]);
+        }
+        return copy;
+    }
+    return crossover_donor(donor);
+}
+
+static Node* crossover_trees(Node* p1, Node* p2) {
+    if (!p1 || !p2) return node_share(p1);
+    int count = 0;
+    return crossover_copy(p1, &count, p2);
+}
+
+Program* evolve_crossover(Program* p1, Program* p2) {
+    Program* child = calloc(1, sizeof(Program));
+    child->root = crossover_trees(p1->root, p2->root);
+    child->depth = node_depth(child->root);
+    child->size = node_size(child->root);
+    child->fitness = -INFINITY;
+    prog_compile(child);
+    return child;
+}
+
+// Simplification
+//
+// A bottom-up pass of semantics-preserving rewrites: constant folding (with
+// the interpreter's wraparound and DIV/MOD-by-zero rules), identities such as
+// x+0, x*1, NEG(NEG(x)), x-x, IDENT chains, IFs with a known condition, and
+// dropping subtrees whose value is never used (SEQ children and the root)
+// when they have no side effects. OUTPUT, in-range MEM_WRITE and library
+// calls (whose bodies may do either, and which change as the library is
+// relearned) are side effects and never removed or reordered. Nodes are
+// rewritten in place, with folded nodes becoming CONST and keeping their
+// type, or replaced by a child. Private trees never allocate, so arena trees
+// stay arena trees. Shared nodes are never edited: a rewrite under one
+// copies the path down to it (node_own), and other programs holding the
+// subtree see no change.
+
+static int node_has_effect(Node* node) {
+    switch (node->op) {
+        case OP_OUTPUT:
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+            return 1;
+        case OP_MEM_WRITE:
+            return node->value >= 0 && node->value < MAX_MEMORY;
+        default:
+            return 0;
+    }
+}
+
+// Value of a child if it is known: CONST, or missing (which executes as 0)
+static int node_const(Node* node, int* value) {
+    if (!node) {
+        *value = 0;
+        return 1;
+    }
+    if (node->op != OP_CONST) return 0;
+    *value = node->value;
+    return 1;
+}
+
+static int is_const(Node* node, int value) {
+    int v;
+    return node_const(node, &v) && v == value;
+}
+
+// Ops whose result is always 0
+static int node_returns_zero(Node* node) {
+    return node && (node->op == OP_OUTPUT || node->op == OP_MEM_WRITE || node->op == OP_SEQ ||
+                    (node->op == OP_CONST && node->value == 0));
+}
+
+static Node* simplify_to_const(Node* node, int value) {
+    if (node->op == OP_CONST && node->value == value) return node;
+    if (node->alloc == NODE_SHARED) {
+        Node* folded = node_create(OP_CONST, value);
+        folded->type = node->type;
+        node_destroy(node);
+        return folded;
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        node_destroy(node->children[i]);
+        node->children[i] = NULL;
+    }
+    node->op = OP_CONST;
+    node->value = value;
+    node->num_children = 0;
+    return node;
+}
+
+static Node* simplify_to_child(Node* node, int k) {
+    Node* child = node->children[k];
+    if (!child) return simplify_to_const(node, 0);  // A missing child executes as 0
+    if (node->alloc == NODE_SHARED) {
+        child = node_share(child);
+    } else {
+        node->children[k] = NULL;
+    }
+    node_destroy(node);
+    return child;
+}
+
+// Rewrite child i with a rewriter's result. For a shared node, pass the
+// child through rewrite_child first: the rewriter then gets a reference of
+// its own, and the node is only copied if the child comes back different.
+static Node* rewrite_child(Node* node, int i) {
+    Node* child = node->children[i];
+    return node->alloc == NODE_SHARED ? node_share(child) : child;
+}
+
+static Node* simplify_set_child(Node* node, int i, Node* child) {
+    if (node->alloc != NODE_SHARED) {
+        node->children[i] = child;
+        return node;
+    }
+    if (child == node->children[i]) {
+        node_destroy(child);    // The rewriter's reference; nothing changed
+        return node;
+    }
+    node = node_own(node);
+    node_destroy(node->children[i]);
+    node->children[i] = child;
+    return node;
+}
+
+// Evaluate a pure op on constant operands exactly as execute_node does
+// (arithmetic wraps). Returns 0 when the op isn't foldable, including
+// INT_MIN / -1, which the interpreter would trap on.
+static int fold_op(int op, int a, int b, int* out) {
+    unsigned ua = (unsigned)a, ub = (unsigned)b;
+    switch (op) {
+        case OP_ADD: *out = (int)(ua + ub); return 1;
+        case OP_SUB: *out = (int)(ua - ub); return 1;
+        case OP_MUL: *out = (int)(ua * ub); return 1;
+        case OP_DIV:
+        case OP_MOD:
+            if (b == -1 && a == INT32_MIN) return 0;
+            *out = b == 0 ? 0 : (op == OP_DIV ? a / b : a % b);
+            return 1;
+        case OP_AND: *out = a & b; return 1;
+        case OP_OR: *out = a | b; return 1;
+        case OP_XOR: *out = a ^ b; return 1;
+        case OP_NOT: *out = ~a; return 1;
+        case OP_EQ: *out = a == b; return 1;
+        case OP_LT: *out = a < b; return 1;
+        case OP_LTE: *out = a <= b; return 1;
+        case OP_GT: *out = a > b; return 1;
+        case OP_ABS: *out = a < 0 ? (int)(0u - ua) : a; return 1;
+        case OP_NEG: *out = (int)(0u - ua); return 1;
+        case OP_MAX: *out = a > b ? a : b; return 1;
+        case OP_MIN: *out = a < b ? a : b; return 1;
+        case OP_SIN: *out = (int)(sin((double)a / 100.0) * 100.0); return 1;
+        case OP_TANH: *out = (int)(tanh((double)a / 100.0) * 100.0); return 1;
+        case OP_STEP: *out = a > 0; return 1;
+        default: return 0;
+    }
+}
+
+// Algebraic identities for a binary op whose operands are already simplified
+static Node* simplify_binary(Node* node, int* pure_children) {
+    Node* x = node->children[0];
+    Node* y = node->children[1];
+    int same = pure_children[0] && pure_children[1] && node_equal(x, y);
+
+    switch (node->op) {
+        case OP_ADD:
+            if (is_const(y, 0)) return simplify_to_child(node, 0);
+            if (is_const(x, 0)) return simplify_to_child(node, 1);
+            break;
+        case OP_SUB:
+            if (is_const(y, 0)) return simplify_to_child(node, 0);
+            if (same) return simplify_to_const(node, 0);
+            break;
+        case OP_MUL:
+            if (is_const(y, 1)) return simplify_to_child(node, 0);
+            if (is_const(x, 1)) return simplify_to_child(node, 1);
+            if ((is_const(y, 0) && pure_children[0]) || (is_const(x, 0) && pure_children[1])) {
+                return simplify_to_const(node, 0);
+            }
+            break;
+        case OP_DIV:
+            if (is_const(y, 1)) return simplify_to_child(node, 0);
+            if ((is_const(y, 0) && pure_children[0]) || (is_const(x, 0) && pure_children[1])) {
+                return simplify_to_const(node, 0);
+            }
+            break;
+        case OP_MOD:
+            if ((is_const(y, 1) || is_const(y, 0)) && pure_children[0]) return simplify_to_const(node, 0);
+            if (is_const(x, 0) && pure_children[1]) return simplify_to_const(node, 0);
+            break;
+        case OP_AND:
+            if (is_const(y, -1)) return simplify_to_child(node, 0);
+            if (is_const(x, -1)) return simplify_to_child(node, 1);
+            if ((is_const(y, 0) && pure_children[0]) || (is_const(x, 0) && pure_children[1])) {
+                return simplify_to_const(node, 0);
+            }
+            if (same) return simplify_to_child(node, 0);
+            break;
+        case OP_OR:
+            if (is_const(y, 0)) return simplify_to_child(node, 0);
+            if (is_const(x, 0)) return simplify_to_child(node, 1);
+            if (same) return simplify_to_child(node, 0);
+            break;
+        case OP_XOR:
+            if (is_const(y, 0)) return simplify_to_child(node, 0);
+            if (is_const(x, 0)) return simplify_to_child(node, 1);
+            if (same) return simplify_to_const(node, 0);
+            break;
+        case OP_MAX:
+        case OP_MIN:
+            if (same) return simplify_to_child(node, 0);
+            break;
+        case OP_EQ:
+        case OP_LTE:
+            if (same) return simplify_to_const(node, 1);
+            break;
+        case OP_LT:
+        case OP_GT:
+            if (same) return simplify_to_const(node, 0);
+            break;
+    }
+    return node;
+}
+
+// used = 0 when the node's value is discarded (SEQ children, the root).
+// Sets *pure when the result has no side effects.
+static Node* simplify_node(Node* node, int used, int* pure) {
+    *pure = 1;
+    if (!node) return NULL;
+
+    int n = node->num_children;
+    int pure_children[MAX_CHILDREN];
+    for (int i = 0; i < n; i++) {
+        int child_used = 1;
+        if (node->op == OP_SEQ) child_used = 0;
+        if (node->op == OP_IF && i > 0) child_used = used;
+        if (node->op == OP_IF_GT && i > 1) child_used = used;
+        node = simplify_set_child(node, i, simplify_node(rewrite_child(node, i), child_used, &pure_children[i]));
+        if (!pure_children[i]) *pure = 0;
+    }
+    if (node_has_effect(node)) *pure = 0;
+
+    // Values nobody reads, and SEQs (always 0), reduce to 0 when effect-free
+    if (*pure && (!used || node->op == OP_SEQ) && node->op != OP_CONST) {
+        return simplify_to_const(node, 0);
+    }
+
+    int a, b;
+    switch (node->op) {
+        case OP_IDENT:
+            return simplify_to_child(node, 0);
+
+        case OP_INPUT:
+            if (node->value < 0 || node->value >= MAX_INPUTS) return simplify_to_const(node, 0);
+            return node;
+        case OP_MEM_READ:
+            if (node->value < 0 || node->value >= MAX_MEMORY) return simplify_to_const(node, 0);
+            return node;
+        case OP_MEM_WRITE:
+            // Out-of-range writes do nothing but evaluate their operand
+            if (!node_has_effect(node)) {
+                if (pure_children[0]) return simplify_to_const(node, 0);
+                if (!used) return simplify_node(simplify_to_child(node, 0), 0, pure);
+            }
+            return node;
+
+        case OP_NOT:
+        case OP_NEG:
+            if (node->children[0] && node->children[0]->op == node->op) {
+                Node* inner = simplify_to_child(node, 0);
+                return simplify_to_child(inner, 0);
+            }
+            break;
+        case OP_ABS:
+        case OP_STEP:
+            if (node->children[0] && node->children[0]->op == node->op) return simplify_to_child(node, 0);
+            break;
+
+        case OP_IF:
+            if (node_const(node->children[0], &a)) {
+                return simplify_to_child(node, a != 0 ? 1 : 2);
+            }
+            if (pure_children[0] && node_equal(node->children[1], node->children[2])) {
+                return simplify_to_child(node, 1);
+            }
+            return node;
+        case OP_IF_GT:
+            if (node_const(node->children[0], &a) && node_const(node->children[1], &b)) {
+                return simplify_to_child(node, a > b ? 2 : 3);
+            }
+            if (pure_children[0] && pure_children[1]) {
+                if (node_equal(node->children[0], node->children[1])) return simplify_to_child(node, 3);
+                if (node_equal(node->children[2], node->children[3])) return simplify_to_child(node, 2);
+            }
+            return node;
+
+        case OP_SEQ: {
+            // An effect-free side is dropped if the SEQ's 0 survives
+            Node* x = node->children[0];
+            Node* y = node->children[1];
+            if (pure_children[0] && y && (!used || node_returns_zero(y))) return simplify_to_child(node, 1);
+            if (pure_children[1] && x && (!used || node_returns_zero(x))) return simplify_to_child(node, 0);
+            return node;
+        }
+
+        case OP_OUTPUT:
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+        case OP_PARAM:
+        case OP_CONST:
+            return node;
+    }
+
+    // Pure arithmetic and comparisons from here on
+    OpInfo* info = get_op_info(node->op);
+    if (!info || info->arity < 1 || info->arity > 2) return node;
+    int value;
+    if (node_const(node->children[0], &a) &&
+        (info->arity == 1 || node_const(node->children[1], &b)) &&
+        fold_op(node->op, a, info->arity == 2 ? b : 0, &value)) {
+        return simplify_to_const(node, value);
+    }
+    if (info->arity == 2) {
+        Node* rewritten = simplify_binary(node, pure_children);
+        if (rewritten != node || rewritten->op == OP_CONST) return rewritten;
+    }
+
+    // A discarded value only needs its side effects; with a single impure
+    // operand that operand alone is enough
+    if (!used) {
+        int impure = -1, count = 0;
+        for (int i = 0; i < node->num_children; i++) {
+            if (!pure_children[i]) {
+                impure = i;
+                count++;
+            }
+        }
+        if (count == 1) return simplify_node(simplify_to_child(node, impure), 0, pure);
+    }
+    return node;
+}
+
+// Simplify a tree whose value is discarded (a program root)
+static Node* simplify_tree(Node* root) {
+    int pure;
+    return simplify_node(root, 0, &pure);
+}
+
+int simplify_mode_parse(const char* name) {
+    if (strcmp(name, "off") == 0 || strcmp(name, "0") == 0) return SIMPLIFY_OFF;
+    if (strcmp(name, "eval") == 0) return SIMPLIFY_EVAL;
+    if (strcmp(name, "genotype") == 0) return SIMPLIFY_GENOTYPE;
+    return -1;
+}
+
+// Simplify the genotype in place
+void evolve_simplify(Program* prog) {
+    if (!prog) return;
+    prog->root = simplify_tree(prog->root);
+    prog_update_metadata(prog);
+}
+
+// Value-range analysis
+//
+// Interval arithmetic over the tree, starting from ranges the task declares
+// for its inputs. A result that could leave the int range (and wrap) is
+// widened to every int, and anything the analysis can't see into (memory,
+// parameters, library calls) is every int too, so the ranges always contain
+// every value the interpreter can produce. IF/IF_GT branches the ranges rule
+// out are dead: the whole IF becomes the live branch, or if the condition has
+// side effects the dead branch becomes CONST 0. Pure subtrees whose range is
+// a single value become that CONST.
+
+static const ValueRange RANGE_ALL = {INT32_MIN, INT32_MAX};
+
+typedef struct {
+    const ValueRange* inputs;
+    int num_inputs;
+    int dead;               // Nodes in branches proven unreachable
+} RangeEnv;
+
+static ValueRange range_make(int64_t lo, int64_t hi) {
+    if (lo < INT32_MIN || hi > INT32_MAX) return RANGE_ALL;
+    return (ValueRange){(int)lo, (int)hi};
+}
+
+static ValueRange range_union(ValueRange a, ValueRange b) {
+    return (ValueRange){a.lo < b.lo ? a.lo : b.lo, a.hi > b.hi ? a.hi : b.hi};
+}
+
+// Hull of four corner values
+static ValueRange range_corners(int64_t c0, int64_t c1, int64_t c2, int64_t c3) {
+    int64_t lo = c0, hi = c0;
+    int64_t c[3] = {c1, c2, c3};
+    for (int i = 0; i < 3; i++) {
+        if (c[i] < lo) lo = c[i];
+        if (c[i] > hi) hi = c[i];
+    }
+    return range_make(lo, hi);
+}
+
+// Quotients for divisors in [blo, bhi], which doesn't contain 0. Truncating
+// division is monotonic in each operand while the divisor keeps its sign.
+static ValueRange range_div_part(ValueRange a, int64_t blo, int64_t bhi) {
+    return range_corners(a.lo / blo, a.lo / bhi, a.hi / blo, a.hi / bhi);
+}
+
+// 0 or 1 from a comparison that is always true, always false, or either
+static ValueRange range_bool(int always, int never) {
+    return (ValueRange){always ? 1 : 0, never ? 0 : 1};
+}
+
+static int64_t range_mask(int64_t v) {
+    int64_t m = 0;
+    while (m < v) m = m * 2 + 1;
+    return m;
+}
+
+static int tanh_scaled(int a) {
+    return (int)(tanh((double)a / 100.0) * 100.0);
+}
+
+// Range of a pure arithmetic or comparison op given its operands' ranges
+static ValueRange range_op(int op, ValueRange a, ValueRange b) {
+    switch (op) {
+        case OP_ADD:
+            return range_make((int64_t)a.lo + b.lo, (int64_t)a.hi + b.hi);
+        case OP_SUB:
+            return range_make((int64_t)a.lo - b.hi, (int64_t)a.hi - b.lo);
+        case OP_MUL:
+            return range_corners((int64_t)a.lo * b.lo, (int64_t)a.lo * b.hi,
+                                 (int64_t)a.hi * b.lo, (int64_t)a.hi * b.hi);
+        case OP_DIV: {
+            if (b.lo == 0 && b.hi == 0) return (ValueRange){0, 0};
+            int has_zero = b.lo <= 0 && b.hi >= 0;
+            ValueRange r = has_zero ? (ValueRange){0, 0} : range_div_part(a, b.lo, b.hi);
+            if (has_zero && b.lo < 0) r = range_union(r, range_div_part(a, b.lo, -1));
+            if (has_zero && b.hi > 0) r = range_union(r, range_div_part(a, 1, b.hi));
+            return r;
+        }
+        case OP_MOD: {
+            // |a % b| < |b| and <= |a|, with the sign of a (or 0)
+            int64_t blo = b.lo < 0 ? -(int64_t)b.lo : b.lo;
+            int64_t bhi = b.hi < 0 ? -(int64_t)b.hi : b.hi;
+            int64_t m = (blo > bhi ? blo : bhi) - 1;
+            if (m < 0) return (ValueRange){0, 0};
+            int64_t lo = a.lo < 0 ? (a.lo > -m ? a.lo : -m) : 0;
+            int64_t hi = a.hi > 0 ? (a.hi < m ? a.hi : m) : 0;
+            return range_make(lo, hi);
+        }
+        case OP_AND:
+            if (a.lo >= 0 && b.lo >= 0) return (ValueRange){0, a.hi < b.hi ? a.hi : b.hi};
+            if (a.lo >= 0) return (ValueRange){0, a.hi};
+            if (b.lo >= 0) return (ValueRange){0, b.hi};
+            return RANGE_ALL;
+        case OP_OR:
+        case OP_XOR:
+            if (a.lo >= 0 && b.lo >= 0) return range_make(0, range_mask(a.hi > b.hi ? a.hi : b.hi));
+            return RANGE_ALL;
+        case OP_NOT:
+            return (ValueRange){~a.hi, ~a.lo};
+        case OP_EQ:
+            return range_bool(a.lo == a.hi && b.lo == b.hi && a.lo == b.lo, a.hi < b.lo || b.hi < a.lo);
+        case OP_LT:
+            return range_bool(a.hi < b.lo, a.lo >= b.hi);
+        case OP_LTE:
+            return range_bool(a.hi <= b.lo, a.lo > b.hi);
+        case OP_GT:
+            return range_bool(a.lo > b.hi, a.hi <= b.lo);
+        case OP_ABS:
+            if (a.lo == INT32_MIN) return RANGE_ALL;    // ABS(INT_MIN) wraps
+            if (a.lo >= 0) return a;
+            if (a.hi <= 0) return (ValueRange){-a.hi, -a.lo};
+            return (ValueRange){0, -a.lo > a.hi ? -a.lo : a.hi};
+        case OP_NEG:
+            if (a.lo == INT32_MIN) return RANGE_ALL;
+            return (ValueRange){-a.hi, -a.lo};
+        case OP_MAX:
+            return (ValueRange){a.lo > b.lo ? a.lo : b.lo, a.hi > b.hi ? a.hi : b.hi};
+        case OP_MIN:
+            return (ValueRange){a.lo < b.lo ? a.lo : b.lo, a.hi < b.hi ? a.hi : b.hi};
+        case OP_SIN:
+            return (ValueRange){-100, 100};
+        case OP_TANH:
+            return (ValueRange){tanh_scaled(a.lo), tanh_scaled(a.hi)};
+        case OP_STEP:
+            return range_bool(a.lo > 0, a.hi <= 0);
+        case OP_IDENT:
+            return a;
+        default:
+            return RANGE_ALL;
+    }
+}
+
+static Node* range_node(Node* node, RangeEnv* env, ValueRange* range, int* pure);
+
+// Replace a branch that can't be taken by CONST 0, counting what it held
+static Node* range_kill_branch(Node* node, int k, RangeEnv* env) {
+    Node* branch = node->children[k];
+    if (!branch) return node;
+    env->dead += node_size(branch);
+    return simplify_set_child(node, k, simplify_to_const(rewrite_child(node, k), 0));
+}
+
+static Node* range_node(Node* node, RangeEnv* env, ValueRange* range, int* pure) {
+    *range = (ValueRange){0, 0};
+    *pure = 1;
+    if (!node) return NULL;
+
+    int n = node->num_children;
+    ValueRange ranges[MAX_CHILDREN] = {{0, 0}};
+    int pure_children[MAX_CHILDREN];
+    int live = -1;          // IF/IF_GT: the only branch that can run
+    int conditions = node->op == OP_IF ? 1 : node->op == OP_IF_GT ? 2 : 0;
+
+    for (int i = 0; i < n; i++) {
+        if (conditions && i == conditions) {
+            if (node->op == OP_IF) {
+                if (ranges[0].lo > 0 || ranges[0].hi < 0) live = 1;
+                if (ranges[0].lo == 0 && ranges[0].hi == 0) live = 2;
+            } else {
+                if (ranges[0].lo > ranges[1].hi) live = 2;
+                if (ranges[0].hi <= ranges[1].lo) live = 3;
+            }
+        }
+        if (live >= 0 && i != live) {
+            node = range_kill_branch(node, i, env);
+            ranges[i] = (ValueRange){0, 0};
+            pure_children[i] = 1;
+            continue;
+        }
+        node = simplify_set_child(node, i, range_node(rewrite_child(node, i), env, &ranges[i], &pure_children[i]));
+        if (!pure_children[i]) *pure = 0;
+    }
+    if (node_has_effect(node)) *pure = 0;
+
+    switch (node->op) {
+        case OP_CONST:
+            *range = (ValueRange){node->value, node->value};
+            return node;
+        case OP_INPUT:
+            if (node->value < 0 || node->value >= MAX_INPUTS) return node;
+            *range = node->value < env->num_inputs ? env->inputs[node->value] : RANGE_ALL;
+            break;
+        case OP_MEM_READ:
+            if (node->value >= 0 && node->value < MAX_MEMORY) *range = RANGE_ALL;
+            return node;
+        case OP_OUTPUT:
+        case OP_MEM_WRITE:
+        case OP_SEQ:
+            return node;
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+        case OP_PARAM:
+            *range = RANGE_ALL;
+            return node;
+        case OP_IF:
+        case OP_IF_GT:
+            if (live >= 0) {
+                *range = ranges[live];
+                // Conditions without side effects go with the dead branch
+                int conditions_pure = pure_children[0] && (conditions == 1 || pure_children[1]);
+                if (conditions_pure) return simplify_to_child(node, live);
+            } else {
+                *range = range_union(ranges[conditions], ranges[conditions + 1]);
+            }
+            return node;
+        default: {
+            OpInfo* info = get_op_info(node->op);
+            if (!info || info->arity < 1 || info->arity > 2) {
+                *range = RANGE_ALL;
+                return node;
+            }
+            *range = range_op(node->op, ranges[0], info->arity == 2 ? ranges[1] : RANGE_ALL);
+            break;
+        }
+    }
+
+    if (*pure && range->lo == range->hi) return simplify_to_const(node, range->lo);
+    return node;
+}
+
+// Prune a tree with the given input ranges; returns the dead node count
+static int range_prune(Node** root, const ValueRange* inputs, int num_inputs) {
+    RangeEnv env = {inputs, num_inputs, 0};
+    ValueRange range;
+    int pure;
+    *root = range_node(*root, &env, &range, &pure);
+    return env.dead;
+}
+
+int prog_prune_dead(Program* prog, const ValueRange* inputs, int num_inputs) {
+    if (!prog || !prog->root) return 0;
+    int dead = range_prune(&prog->root, inputs, num_inputs);
+    prog_update_metadata(prog);
+    return dead;
+}
+
+// PopConfig.simplify for a new program: either the genotype, or only the
+// tree its bytecode is compiled from. With declared input ranges, dead
+// branches go first. Counts go to GenerationStats.
+static void simplify_offspring(Population* pop, Program* prog) {
+    if (!pop->simplify || !prog || !prog->root) return;
+    int before = prog->size;
+    int after;
+    int dead = 0;
+    if (pop->simplify == SIMPLIFY_GENOTYPE) {
+        if (pop->num_input_ranges > 0) dead = range_prune(&prog->root, pop->input_ranges, pop->num_input_ranges);
+        evolve_simplify(prog);
+        after = prog->size;
+    } else {
+        // Only the bytecode outlives the copy. It comes from the same arena
+        // as the offspring (reclaimed at the next reset) or the heap.
+        Node* phenotype = node_share(prog->root);
+        if (pop->num_input_ranges > 0) dead = range_prune(&phenotype, pop->input_ranges, pop->num_input_ranges);
+        phenotype = simplify_tree(phenotype);
+        after = node_size(phenotype);
+        bytecode_destroy(prog->code);
+        prog->code = bytecode_compile(phenotype);
+        node_destroy(phenotype);
+    }
+    __atomic_fetch_add(&pop->simplify_programs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pop->simplify_nodes_in, (uint64_t)before, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pop->simplify_nodes_out, (uint64_t)after, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pop->dead_nodes, (uint64_t)dead, __ATOMIC_RELAXED);
+}
+
+// Last step for every new program before it joins the population
+static void finish_offspring(Population* pop, Program* prog) {
+    simplify_offspring(pop, prog);
+    if (pop->share_subtrees && prog) prog->root = node_intern(prog->root);
+}
+
+// Per-worker data for parallel fitness evaluation
+typedef struct {
+    int programs;
+    double busy;
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t nodes;         // Nodes executed while scoring (see gp_count_nodes)
+    double breeding;        // Pipelined mode: time spent breeding during evaluation
+    int offspring;          // Pipelined mode: offspring bred during evaluation
+} ThreadData;
+
+typedef struct {
+    Population* pop;
+    FitnessFn fitness_fn;
+    void* data;
+    ThreadData* threads;
+    const int* order;   // Evaluation order (indices into pop->programs)
+    int batch;
+    int next;           // Next position in order, claimed atomically
+    uint64_t seed;      // Evaluation stream of this generation
+    uint64_t cache_tag;
+    int mark_scored;    // Pipelined mode: flag programs in pop->scored as they finish
+    int num_scored;     // Pipelined mode: programs scored so far
+} EvalJob;
+
+// Random streams derived from the run seed, one per (kind, generation, index)
+enum {
+    STREAM_INIT,
+    STREAM_EVAL,
+    STREAM_BREED,
+    STREAM_STEADY,
+};
+
+static uint64_t generation_stream(Population* pop, int kind, int generation, int idx) {
+    return rng_derive(pop->seed, ((uint64_t)kind << 32) | (uint32_t)generation, (uint64_t)idx);
+}
+
+static uint64_t pop_stream(Population* pop, int kind, int idx) {
+    return generation_stream(pop, kind, pop->generation, idx);
+}
+
+// Score one program; every program of a generation gets the same stream
+static float evaluate_program(Program* prog, FitnessFn fitness_fn, void* data, uint64_t seed, int idx) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    gp_seed(rng_derive(seed, (uint64_t)idx, 0));
+    return fitness_fn(prog, data, &rng);
+}
+
+// Tag for this generation's cache keys; stochastic tasks only share results
+// between programs evaluated on the same stream
+static uint64_t fitness_cache_tag(Population* pop, int generation) {
+    uint64_t gen = pop->deterministic_fitness ? 0 : (uint64_t)generation + 1;
+    return rng_derive((uint64_t)pop->library_version, gen, 0);
+}
+
+static float evaluate_cached(Population* pop, Program* prog, FitnessFn fitness_fn, void* data,
+                             uint64_t seed, uint64_t tag, int idx, ThreadData* td) {
+    if (!pop->cache) {
+        td->cache_misses++;
+        return evaluate_program(prog, fitness_fn, data, seed, idx);
+    }
+    uint64_t key = fitness_cache_key(prog->hash, tag);
+    float fitness;
+    if (fitness_cache_lookup(pop->cache, key, &fitness)) {
+        td->cache_hits++;
+        return fitness;
+    }
+    fitness = evaluate_program(prog, fitness_fn, data, seed, idx);
+    fitness_cache_insert(pop->cache, key, fitness);
+    td->cache_misses++;
+    return fitness;
+}
+
+// Largest programs first, ties in population order (counting sort on size)
+static void order_by_size(Population* pop, int* order) {
+    int max_size = 0;
+    for (int i = 0; i < pop->pop_size; i++) {
+        if (pop->programs[i] && pop->programs[i]->size > max_size) max_size = pop->programs[i]->size;
+    }
+
+    int* start = calloc(max_size + 2, sizeof(int));
+    for (int i = 0; i < pop->pop_size; i++) {
+        int size = pop->programs[i] ? pop->programs[i]->size : 0;
+        start[max_size - size + 1]++;
+    }
+    for (int b = 1; b <= max_size + 1; b++) start[b] += start[b - 1];
+    for (int i = 0; i < pop->pop_size; i++) {
+        int size = pop->programs[i] ? pop->programs[i]->size : 0;
+        order[start[max_size - size]++] = i;
+    }
+    free(start);
+}
+
+// Claim the next batch of the evaluation order and score it. Returns 0 once
+// everything has been claimed.
+static int evaluate_next_batch(EvalJob* job, ThreadData* td) {
+    Population* pop = job->pop;
+    int begin = __atomic_fetch_add(&job->next, job->batch, __ATOMIC_RELAXED);
+    if (begin >= pop->pop_size) return 0;
+    int end = begin + job->batch < pop->pop_size ? begin + job->batch : pop->pop_size;
+    uint64_t nodes = gp_nodes_executed();
+
+    for (int k = begin; k < end; k++) {
+        int i = job->order[k];
+        if (!pop->programs[i]) continue;
+
+        pop->programs[i]->fitness = evaluate_cached(pop, pop->programs[i], job->fitness_fn,
+                                                    job->data, job->seed, job->cache_tag, i, td);
+        td->programs++;
+        if (job->mark_scored) __atomic_store_n(&pop->scored[i], 1, __ATOMIC_RELEASE);
+    }
+    td->nodes += gp_nodes_executed() - nodes;
+    if (job->mark_scored) __atomic_fetch_add(&job->num_scored, end - begin, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Pool task for fitness evaluation. Workers repeatedly claim the next batch
+// of programs from a shared counter, so a thread stuck on a long episode
+// doesn't hold up programs the others could be scoring.
+static void evaluate_fitness_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    EvalJob* job = (EvalJob*)arg;
+    ThreadData* td = &job->threads[worker];
+    double start = now_seconds();
+
+    memset(td, 0, sizeof(*td));
+    while (evaluate_next_batch(job, td)) {
+    }
+
+    td->busy = now_seconds() - start;
+}
+
+// Tournament selection
+Program* tournament_select(Population* pop) {
+    Program* best = NULL;
+    float best_fitness = -INFINITY;
+
+    for (int i = 0; i < pop->tournament_size; i++) {
+        int idx = random_int(pop->pop_size);
+        if (pop->programs[idx] && pop->programs[idx]->fitness > best_fitness) {
+            best = pop->programs[idx];
+            best_fitness = pop->programs[idx]->fitness;
+        }
+    }
+
+    return best;
+}
+
+// Ranking
+
+// Fitness order shared by elitism, stats and library learning: higher
+// fitness first, missing programs and NaN last, ties broken by index
+static float rank_fitness(Program** programs, int i) {
+    Program* prog = programs[i];
+    if (!prog || isnan(prog->fitness)) return -INFINITY;
+    return prog->fitness;
+}
+
+static int ranks_before(Program** programs, int a, int b) {
+    float fa = rank_fitness(programs, a);
+    float fb = rank_fitness(programs, b);
+    if (fa != fb) return fa > fb;
+    return a < b;
+}
+
+// Quickselect: reorder idx[0..n) so that idx[0..k) are the k best, unordered
+static void select_top(Program** programs, int* idx, int n, int k) {
+    if (k <= 0 || k >= n) return;
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        int pivot = idx[lo + (hi - lo) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (ranks_before(programs, idx[i], pivot)) i++;
+            while (ranks_before(programs, pivot, idx[j])) j--;
+            if (i <= j) {
+                int tmp = idx[i];
+                idx[i++] = idx[j];
+                idx[j--] = tmp;
+            }
+        }
+        if (k - 1 <= j) hi = j;
+        else if (k - 1 >= i) lo = i;
+        else break;
+    }
+}
+
+static void sort_ranked(Program** programs, int* idx, int n) {
+    for (int i = 1; i < n; i++) {
+        int cur = idx[i];
+        int j = i - 1;
+        while (j >= 0 && ranks_before(programs, cur, idx[j])) {
+            idx[j + 1] = idx[j];
+            j--;
+        }
+        idx[j + 1] = cur;
+    }
+}
+
+typedef struct {
+    Population* pop;
+    int k;
+} RankJob;
+
+static void rank_chunk(int n, int worker, int num_workers, int* lo, int* hi) {
+    *lo = (int)((long)n * worker / num_workers);
+    *hi = (int)((long)n * (worker + 1) / num_workers);
+}
+
+// Pool task: each worker selects the best k of its slice of the population
+static void rank_chunk_task(void* arg, int worker, int num_workers) {
+    RankJob* job = (RankJob*)arg;
+    Population* pop = job->pop;
+    int lo, hi;
+    rank_chunk(pop->pop_size, worker, num_workers, &lo, &hi);
+    for (int i = lo; i < hi; i++) pop->ranking[i] = i;
+    select_top(pop->programs, pop->ranking + lo, hi - lo, job->k);
+}
+
+// Rank the current population: select per worker slice, then merge the
+// slice winners and sort the overall top RANK_TOP (or elite_size)
+void pop_rank(Population* pop) {
+    int k = pop->elite_size > RANK_TOP ? pop->elite_size : RANK_TOP;
+    if (k > pop->pop_size) k = pop->pop_size;
+    int num_workers = pool_size(pop->pool);
+    RankJob job = {pop, k};
+    pool_run(pop->pool, rank_chunk_task, &job);
+
+    // Gather the slice winners at the front (swapping keeps a permutation)
+    int n = 0;
+    for (int w = 0; w < num_workers; w++) {
+        int lo, hi;
+        rank_chunk(pop->pop_size, w, num_workers, &lo, &hi);
+        int m = hi - lo < k ? hi - lo : k;
+        for (int j = 0; j < m; j++, n++) {
+            int tmp = pop->ranking[n];
+            pop->ranking[n] = pop->ranking[lo + j];
+            pop->ranking[lo + j] = tmp;
+        }
+    }
+
+    select_top(pop->programs, pop->ranking, n, k);
+    sort_ranked(pop->programs, pop->ranking, k);
+    pop->num_ranked = k;
+}
+
+// Parallel construction of new programs. Workers claim batches of indices;
+// program i is built from its own random stream into the worker's arena, so
+// the result doesn't depend on which thread built it.
+#define BREED_BATCH 16
+
+typedef struct {
+    Population* pop;
+    Program** out;
+    int end;
+    int parity;         // Arena set the new programs are allocated from (-1 = heap)
+    int next;           // Next index, claimed atomically
+} BreedJob;
+
+// Arena new programs are built in (NULL = heap). Shared trees are interned
+// from heap nodes, whose release also releases the shared subtrees under
+// them, so they never use one.
+static NodeArena* breed_arena(Population* pop, int parity, int worker) {
+    if (!pop->use_arena || pop->share_subtrees || parity < 0) return NULL;
+    return pop->arenas[parity][worker];
+}
+
+static void create_initial_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    BreedJob* job = (BreedJob*)arg;
+    Population* pop = job->pop;
+    NodeArena* saved = node_arena_use(breed_arena(pop, job->parity, worker));
+
+    for (;;) {
+        int begin = __atomic_fetch_add(&job->next, BREED_BATCH, __ATOMIC_RELAXED);
+        if (begin >= job->end) break;
+        int end = begin + BREED_BATCH < job->end ? begin + BREED_BATCH : job->end;
+
+        for (int i = begin; i < end; i++) {
+            gp_seed(pop_stream(pop, STREAM_INIT, i));
+            job->out[i] = create_random_program(5, pop->num_inputs, pop->boolean_ops);
+            finish_offspring(pop, job->out[i]);
+        }
+    }
+
+    node_arena_use(saved);
+}
+
+static Program* breed_offspring(Population* pop, int i) {
+    gp_seed(pop_stream(pop, STREAM_BREED, i));
+    Program* child;
+    if (random_int(10) < 7) {  // 70% crossover
+        Program* p1 = tournament_select(pop);
+        Program* p2 = tournament_select(pop);
+        child = evolve_crossover(p1, p2);
+    } else {  // 30% mutation
+        Program* parent = tournament_select(pop);
+        child = evolve_mutate(parent, pop);
+    }
+    finish_offspring(pop, child);
+    return child;
+}
+
+static void breed_offspring_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    BreedJob* job = (BreedJob*)arg;
+    Population* pop = job->pop;
+    NodeArena* saved = node_arena_use(breed_arena(pop, job->parity, worker));
+
+    for (;;) {
+        int begin = __atomic_fetch_add(&job->next, BREED_BATCH, __ATOMIC_RELAXED);
+        if (begin >= job->end) break;
+        int end = begin + BREED_BATCH < job->end ? begin + BREED_BATCH : job->end;
+
+        for (int i = begin; i < end; i++) {
+            job->out[i] = breed_offspring(pop, i);
+        }
+    }
+
+    node_arena_use(saved);
+}
+
+static void reset_arenas(Population* pop, int parity) {
+    if (!pop->use_arena) return;
+    for (int t = 0; t < pop->num_threads; t++) {
+        pop->arena_allocs += pop->arenas[parity][t]->allocated;
+        node_arena_reset(pop->arenas[parity][t]);
+    }
+}
+
+// Score every program of the current generation on the pool; returns the
+// wall time of the phase
+static void eval_job_init(EvalJob* job, Population* pop, FitnessFn fitness_fn, void* data, ThreadData* threads) {
+    int* order = pop->eval_order;
+    if (pop->eval_largest_first) {
+        order_by_size(pop, order);
+    } else {
+        for (int i = 0; i < pop->pop_size; i++) order[i] = i;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->pop = pop;
+    job->fitness_fn = fitness_fn;
+    job->data = data;
+    job->threads = threads;
+    job->order = order;
+    job->batch = pop->eval_batch > 0 ? pop->eval_batch : 1;
+    job->seed = pop_stream(pop, STREAM_EVAL, 0);
+    job->cache_tag = fitness_cache_tag(pop, pop->generation);
+}
+
+static double evaluate_population(Population* pop, FitnessFn fitness_fn, void* data, ThreadData* threads) {
+    EvalJob eval_job;
+    eval_job_init(&eval_job, pop, fitness_fn, data, threads);
+    double eval_start = now_seconds();
+    pool_run(pop->pool, evaluate_fitness_task, &eval_job);
+    return now_seconds() - eval_start;
+}
+
+// Pipelined generations
+//
+// Breeding only needs the fitness of the programs an offspring's
+// tournaments draw, and those draws come from the offspring's own stream
+// before any fitness is read. So once pipeline_threshold of the population
+// is scored, workers interleave breeding with evaluation: an offspring whose
+// draws are all scored is bred at once, the others are deferred until they
+// are. The results are exactly what breed_offspring_task would produce.
+//
+// Library learning needs the finished ranking, so it is deferred instead:
+// the generation is snapshotted (see library_snapshot_take), worker 0 learns
+// from it while the next generation is evaluated, and the new library is
+// installed once that generation's offspring are bred.
+
+typedef struct {
+    EvalJob* eval;
+    BreedJob* breed;
+    LibrarySnapshot* snapshot;  // Learned from by worker 0 first (NULL = none)
+    int threshold;              // Programs scored before breeding starts
+    double library_time;
+} PipelineJob;
+
+typedef struct {
+    int* items;
+    int count;
+    int cap;
+} Deferred;
+
+// Replays offspring i's draws up to its tournaments (see breed_offspring)
+static int offspring_ready(Population* pop, int i) {
+    Rng rng;
+    rng_seed(&rng, pop_stream(pop, STREAM_BREED, i));
+    int draws = (rng_int(&rng, 10) < 7 ? 2 : 1) * pop->tournament_size;
+    for (int n = 0; n < draws; n++) {
+        if (!__atomic_load_n(&pop->scored[rng_int(&rng, pop->pop_size)], __ATOMIC_ACQUIRE)) return 0;
+    }
+    return 1;
+}
+
+static void pipeline_breed(PipelineJob* job, int worker, Deferred* deferred, int begin, int end) {
+    Population* pop = job->eval->pop;
+    ThreadData* td = &job->eval->threads[worker];
+    double start = now_seconds();
+    NodeArena* saved = node_arena_use(breed_arena(pop, job->breed->parity, worker));
+
+    // Earlier deferrals first, then the new range
+    int kept = 0;
+    for (int k = 0; k < deferred->count; k++) {
+        int i = deferred->items[k];
+        if (offspring_ready(pop, i)) {
+            job->breed->out[i] = breed_offspring(pop, i);
+            td->offspring++;
+        } else {
+            deferred->items[kept++] = i;
+        }
+    }
+    deferred->count = kept;
+
+    for (int i = begin; i < end; i++) {
+        if (offspring_ready(pop, i)) {
+            job->breed->out[i] = breed_offspring(pop, i);
+            td->offspring++;
+        } else {
+            if (deferred->count == deferred->cap) {
+                deferred->cap = deferred->cap ? deferred->cap * 2 : 64;
+                deferred->items = realloc(deferred->items, sizeof(int) * deferred->cap);
+            }
+            deferred->items[deferred->count++] = i;
+        }
+    }
+
+    node_arena_use(saved);
+    td->breeding += now_seconds() - start;
+}
+
+// Claim the next range of offspring and breed what's ready. Returns 0 once
+// everything has been claimed.
+static int pipeline_breed_next(PipelineJob* job, int worker, Deferred* deferred) {
+    BreedJob* breed = job->breed;
+    int begin = __atomic_fetch_add(&breed->next, BREED_BATCH, __ATOMIC_RELAXED);
+    if (begin >= breed->end) return 0;
+    int end = begin + BREED_BATCH < breed->end ? begin + BREED_BATCH : breed->end;
+    pipeline_breed(job, worker, deferred, begin, end);
+    return 1;
+}
+
+static void pipeline_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    PipelineJob* job = (PipelineJob*)arg;
+    EvalJob* eval = job->eval;
+    ThreadData* td = &eval->threads[worker];
+    Deferred deferred = {NULL, 0, 0};
+    double start = now_seconds();
+    memset(td, 0, sizeof(*td));
+
+    if (worker == 0 && job->snapshot) {
+        library_snapshot_learn(job->snapshot);
+        job->library_time = now_seconds() - start;
+    }
+
+    while (evaluate_next_batch(eval, td)) {
+        if (__atomic_load_n(&eval->num_scored, __ATOMIC_ACQUIRE) >= job->threshold) {
+            pipeline_breed_next(job, worker, &deferred);
+        }
+    }
+
+    // Nothing left to score: breed the rest, yielding while deferred
+    // offspring wait on programs other workers are still scoring
+    while (pipeline_breed_next(job, worker, &deferred)) {
+    }
+    while (deferred.count > 0) {
+        int waiting = deferred.count;
+        pipeline_breed(job, worker, &deferred, 0, 0);
+        if (deferred.count == waiting) sched_yield();
+    }
+
+    free(deferred.items);
+    td->busy = now_seconds() - start;
+}
+
+// Generation statistics
+
+const char* gp_phase_names[PHASE_COUNT] = {
+    "init", "eval", "reduce", "rank", "elitism", "breed", "library", "replace",
+};
+
+static double cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Phases are timed back to back: phase_end charges everything since the
+// previous mark to `phase`
+typedef struct {
+    Population* pop;
+    double start;
+    double wall;
+    double cpu;
+    uint64_t perf[PERF_COUNT];  // Hardware counters, all workers
+} PhaseMark;
+
+static void pop_perf_read(Population* pop, uint64_t totals[PERF_COUNT]) {
+    memset(totals, 0, sizeof(uint64_t) * PERF_COUNT);
+    for (int t = 0; t < pop->num_threads && pop->perf[t]; t++) {
+        uint64_t values[PERF_COUNT];
+        perf_read(pop->perf[t], values);
+        for (int e = 0; e < PERF_COUNT; e++) totals[e] += values[e];
+    }
+}
+
+static void phase_end(GenerationStats* stats, int phase, PhaseMark* mark) {
+    double wall = now_seconds();
+    double cpu = cpu_seconds();
+    stats->phase_wall[phase] += wall - mark->wall;
+    stats->phase_cpu[phase] += cpu - mark->cpu;
+    mark->wall = wall;
+    mark->cpu = cpu;
+    if (stats->perf_available) {
+        uint64_t perf[PERF_COUNT];
+        pop_perf_read(mark->pop, perf);
+        for (int e = 0; e < PERF_COUNT; e++) {
+            // Multiplexed counts are scaled estimates and can step back
+            if (perf[e] > mark->perf[e]) stats->phase_perf[phase][e] += perf[e] - mark->perf[e];
+            mark->perf[e] = perf[e];
+        }
+    }
+}
+
+// Nodes allocated so far: heap nodes (process wide) plus everything this
+// population's arenas have handed out
+static uint64_t pop_node_allocs(Population* pop) {
+    AllocStats alloc;
+    gp_alloc_stats(&alloc);
+    uint64_t n = alloc.heap_nodes + pop->arena_allocs;
+    for (int t = 0; t < pop->num_threads; t++) {
+        n += pop->arenas[0][t]->allocated + pop->arenas[1][t]->allocated;
+    }
+    return n;
+}
+
+static void stats_begin(Population* pop, PhaseMark* mark) {
+    GenerationStats* stats = &pop->stats;
+    memset(stats->phase_wall, 0, sizeof(stats->phase_wall));
+    memset(stats->phase_cpu, 0, sizeof(stats->phase_cpu));
+    stats->generation = pop->generation;
+    stats->overlap_breed_time = 0;
+    stats->overlap_library_time = 0;
+    stats->overlap_offspring = 0;
+    stats->node_allocs = pop_node_allocs(pop);  // Baseline; the delta is taken later
+    pop->lock_wait_ns = 0;
+    pop->slot_wait_ns = 0;
+    pop->lock_contentions = 0;
+    pop->simplify_programs = 0;
+    pop->simplify_nodes_in = 0;
+    pop->simplify_nodes_out = 0;
+    pop->dead_nodes = 0;
+    if (pop->cache) {
+        pop->cache->wait_ns = 0;
+        pop->cache->contentions = 0;
+    }
+    memset(stats->phase_perf, 0, sizeof(stats->phase_perf));
+#ifdef GP_PROFILE
+    gp_profile_totals(&stats->ops);     // Baseline; the delta is taken in stats_end
+#endif
+    stats->perf_available = pop->perf[0] ? perf_available(pop->perf[0]) : 0;
+    mark->pop = pop;
+    if (stats->perf_available) pop_perf_read(pop, mark->perf);
+    mark->start = now_seconds();
+    mark->wall = mark->start;
+    mark->cpu = cpu_seconds();
+}
+
+static void stats_collect_threads(GenerationStats* stats, ThreadData* threads, int num_threads, double eval_time) {
+    stats->num_threads = num_threads;
+    stats->eval_time = eval_time;
+    stats->cache_hits = 0;
+    stats->cache_misses = 0;
+    stats->nodes_executed = 0;
+    for (int i = 0; i < num_threads; i++) {
+        stats->cache_hits += threads[i].cache_hits;
+        stats->cache_misses += threads[i].cache_misses;
+        stats->nodes_executed += threads[i].nodes;
+        stats->thread_busy[i] = threads[i].busy;
+        stats->thread_idle[i] = eval_time > threads[i].busy ? eval_time - threads[i].busy : 0.0;
+        stats->thread_programs[i] = threads[i].programs;
+        stats->overlap_breed_time += threads[i].breeding;
+        stats->overlap_offspring += threads[i].offspring;
+    }
+    stats->nodes_per_sec = eval_time > 0 ? stats->nodes_executed / eval_time : 0.0;
+}
+
+static void stats_end(Population* pop, PhaseMark* mark) {
+    GenerationStats* stats = &pop->stats;
+    stats->wall_time = now_seconds() - mark->start;
+    stats->lock_wait = pop->lock_wait_ns * 1e-9;
+    stats->slot_lock_wait = pop->slot_wait_ns * 1e-9;
+    stats->cache_lock_wait = pop->cache ? pop->cache->wait_ns * 1e-9 : 0.0;
+    stats->lock_contentions = pop->lock_contentions + (pop->cache ? pop->cache->contentions : 0);
+    stats->simplify_programs = pop->simplify_programs;
+    stats->simplify_nodes_in = pop->simplify_nodes_in;
+    stats->simplify_nodes_out = pop->simplify_nodes_out;
+    stats->dead_nodes = pop->dead_nodes;
+    if (pop->share_subtrees) {
+        AllocStats alloc;
+        gp_alloc_stats(&alloc);
+        stats->tree_nodes = 0;
+        for (int i = 0; i < pop->pop_size; i++) {
+            if (pop->programs[i]) stats->tree_nodes += pop->programs[i]->size;
+        }
+        stats->unique_nodes = alloc.shared_nodes;
+    }
+#ifdef GP_PROFILE
+    OpProfile totals;
+    gp_profile_totals(&totals);
+    for (int op = 0; op < OP_COUNT; op++) {
+        stats->ops.count[op] = totals.count[op] - stats->ops.count[op];
+        stats->ops.cycles[op] = totals.cycles[op] - stats->ops.cycles[op];
+    }
+#endif
+    stats->evals_per_sec = stats->wall_time > 0 ? stats->evaluations / stats->wall_time : 0.0;
+
+    if (pop->stats_json) {
+        char line[4096];
+        int n = pop_stats_json(pop, line, sizeof(line));
+        if (n > 0 && (size_t)n < sizeof(line)) {
+            fputs(line, pop->stats_json);
+            fputc('\n', pop->stats_json);
+            fflush(pop->stats_json);
+        }
+    }
+}
+
+typedef struct {
+    char* buf;
+    size_t cap;
+    size_t len;         // Characters produced, including any that did not fit
+    int fields;
+} JsonOut;
+
+static void json_printf(JsonOut* out, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out->len < out->cap ? out->buf + out->len : NULL,
+                      out->len < out->cap ? out->cap - out->len : 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) out->len += n;
+}
+
+// JSON has no infinities or NaN; those are written as null
+static void json_number(JsonOut* out, const char* name, double v) {
+    json_printf(out, "%s\"%s\":", out->fields++ ? "," : "", name);
+    if (isfinite(v)) {
+        json_printf(out, "%.9g", v);
+    } else {
+        json_printf(out, "null");
+    }
+}
+
+static void json_count(JsonOut* out, const char* name, uint64_t v) {
+    json_printf(out, "%s\"%s\":%llu", out->fields++ ? "," : "", name, (unsigned long long)v);
+}
+
+int pop_stats_json(Population* pop, char* buf, size_t cap) {
+    GenerationStats* stats = &pop->stats;
+    JsonOut out = {buf, cap, 0, 0};
+    if (cap > 0) buf[0] = '\0';
+
+    json_printf(&out, "{");
+    json_count(&out, "generation", stats->generation);
+    json_count(&out, "threads", stats->num_threads);
+    json_number(&out, "best", stats->best_fitness);
+    json_number(&out, "worst", stats->worst_fitness);
+    json_number(&out, "avg", pop->avg_fitness);
+    json_number(&out, "best_ever", pop->best_fitness);
+    json_count(&out, "evaluations", stats->evaluations);
+    json_number(&out, "wall", stats->wall_time);
+    json_number(&out, "evals_per_sec", stats->evals_per_sec);
+    json_count(&out, "nodes_executed", stats->nodes_executed);
+    json_number(&out, "nodes_per_sec", stats->nodes_per_sec);
+    json_count(&out, "node_allocs", stats->node_allocs);
+    json_number(&out, "mean_size", stats->mean_size);
+    json_count(&out, "max_size", stats->max_size);
+    json_count(&out, "cache_hits", stats->cache_hits);
+    json_count(&out, "cache_misses", stats->cache_misses);
+    json_count(&out, "overlap_offspring", stats->overlap_offspring);
+    json_number(&out, "overlap_breed", stats->overlap_breed_time);
+    json_number(&out, "overlap_library", stats->overlap_library_time);
+    json_number(&out, "lock_wait", stats->lock_wait);
+    json_number(&out, "cache_lock_wait", stats->cache_lock_wait);
+    json_number(&out, "slot_lock_wait", stats->slot_lock_wait);
+    json_count(&out, "lock_contentions", stats->lock_contentions);
+    if (pop->simplify) {
+        json_count(&out, "simplify_programs", stats->simplify_programs);
+        json_count(&out, "simplify_nodes_in", stats->simplify_nodes_in);
+        json_count(&out, "simplify_nodes_out", stats->simplify_nodes_out);
+        json_count(&out, "dead_nodes", stats->dead_nodes);
+    }
+    if (pop->share_subtrees) {
+        json_count(&out, "tree_nodes", stats->tree_nodes);
+        json_count(&out, "unique_nodes", stats->unique_nodes);
+    }
+    json_printf(&out, ",\"phases\":{");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        json_printf(&out, "%s\"%s\":{\"wall\":%.9g,\"cpu\":%.9g", p ? "," : "",
+                    gp_phase_names[p], stats->phase_wall[p], stats->phase_cpu[p]);
+        for (int e = 0; e < PERF_COUNT; e++) {
+            if (!(stats->perf_available & (1u << e))) continue;
+            json_printf(&out, ",\"%s\":%llu", gp_perf_names[e],
+                        (unsigned long long)stats->phase_perf[p][e]);
+        }
+        json_printf(&out, "}");
+    }
+    json_printf(&out, "}");
+    if (gp_profile_enabled()) {
+        json_printf(&out, ",\"ops\":{");
+        int first = 1;
+        for (int op = 0; op < OP_COUNT; op++) {
+            if (!stats->ops.count[op] && !stats->ops.cycles[op]) continue;
+            json_printf(&out, "%s\"%s\":[%llu,%llu]", first ? "" : ",", get_op_info(op)->name,
+                        (unsigned long long)stats->ops.count[op],
+                        (unsigned long long)stats->ops.cycles[op]);
+            first = 0;
+        }
+        json_printf(&out, "}");
+    }
+    json_printf(&out, "}");
+    return (int)out.len;
+}
+
+// Evolution
+void evolve_generation(Population* pop, FitnessFn fitness_fn, void* data, int num_inputs) {
+    // Store num_inputs in population
+    pop->num_inputs = num_inputs;
+    GenerationStats* stats = &pop->stats;
+    PhaseMark mark;
+    stats_begin(pop, &mark);
+
+    // Offspring bred this generation go into one set of arenas; the
+    // population being replaced lives in the other and is released in one go
+    // after the swap
+    int offspring_parity = pop->generation & 1;
+    int parent_parity = offspring_parity ^ 1;
+
+    // Initialize population if empty
+    if (!pop->programs[0]) {
+        BreedJob init_job = {pop, pop->programs, pop->pop_size, parent_parity, 0};
+        pool_run(pop->pool, create_initial_task, &init_job);
     }
-    for (int i = 0; i < pop->library_size; i++) {
-        node_destroy(pop->library[i].tree);
+    phase_end(stats, PHASE_INIT, &mark);
+
+    // Offspring go to new_pop[elite_size..pop_size); the elites are filled in
+    // once the ranking is known
+    Program** new_pop = pop->next_programs;
+    BreedJob breed_job = {pop, new_pop, pop->pop_size, offspring_parity, pop->elite_size};
+
+    // Evaluate fitness in parallel on the persistent pool (pipelined: and
+    // breed, and learn from the last library snapshot, at the same time)
+    int num_threads = pool_size(pop->pool);
+    ThreadData thread_data[num_threads];
+    double eval_time;
+    if (pop->pipeline) {
+        EvalJob eval_job;
+        eval_job_init(&eval_job, pop, fitness_fn, data, thread_data);
+        eval_job.mark_scored = 1;
+        memset(pop->scored, 0, pop->pop_size);
+        PipelineJob pipe_job = {&eval_job, &breed_job, pop->library_snapshot,
+                                (int)(pop->pipeline_threshold * pop->pop_size), 0};
+        double eval_start = now_seconds();
+        pool_run(pop->pool, pipeline_task, &pipe_job);
+        eval_time = now_seconds() - eval_start;
+        stats->overlap_library_time = pipe_job.library_time;
+    } else {
+        eval_time = evaluate_population(pop, fitness_fn, data, thread_data);
     }
-    prog_destroy(pop->best);
-    pthread_mutex_destroy(&pop->lock);
-    free(pop);
-}
+    phase_end(stats, PHASE_EVAL, &mark);
+    stats_collect_threads(stats, thread_data, num_threads, eval_time);
 
-// Mutation: replace a random subtree
-static Node* mutate_tree(Node* node, int depth, int num_inputs) {
-    if (!node) return NULL;
+    // Reduce in population order so the result doesn't depend on scheduling
+    float total_fitness = 0;
+    float worst_fitness = INFINITY;
+    uint64_t total_size = 0;
+    int max_size = 0;
+    for (int i = 0; i < pop->pop_size; i++) {
+        if (!pop->programs[i]) continue;
+        total_fitness += pop->programs[i]->fitness;
+        float f = rank_fitness(pop->programs, i);
+        if (f < worst_fitness) worst_fitness = f;
+        total_size += pop->programs[i]->size;
+        if (pop->programs[i]->size > max_size) max_size = pop->programs[i]->size;
+    }
+    pop->avg_fitness = total_fitness / pop->pop_size;
+    stats->worst_fitness = worst_fitness;
+    stats->mean_size = (double)total_size / pop->pop_size;
+    stats->max_size = max_size;
+    phase_end(stats, PHASE_REDUCE, &mark);
+
+    pop_rank(pop);
+    Program* gen_best = pop->programs[pop->ranking[0]];
+    stats->best_fitness = rank_fitness(pop->programs, pop->ranking[0]);
+    if (gen_best && gen_best->fitness > pop->best_fitness) {
+        prog_destroy(pop->best);
+        pop->best = prog_copy(gen_best);
+        pop->best_fitness = gen_best->fitness;
+    }
+    phase_end(stats, PHASE_RANK, &mark);
 
-    // 20% chance to replace this subtree
-    if (rand() % 5 == 0) {
-        node_destroy(node);
-        return create_random_tree(depth, rand() % 2 == 0 ? TYPE_INT : TYPE_VOID, num_inputs);
+    // Create new generation
+    NodeArena* saved_arena = node_arena_use(breed_arena(pop, offspring_parity, 0));
+
+    // Elitism: keep best programs
+    for (int i = 0; i < pop->elite_size; i++) {
+        new_pop[i] = prog_copy(pop->programs[pop->ranking[i]]);
     }
 
-    // Recursively mutate children
-    Node* copy = node_create(node->op, node->value);
-    copy->num_children = node->num_children;
-    for (int i = 0; i < node->num_children; i++) {
-        copy->children[i] = mutate_tree(node_copy(node->children[i]), depth + 1, num_inputs);
+    node_arena_use(saved_arena);
+    phase_end(stats, PHASE_ELITISM, &mark);
+
+    // Generate offspring in parallel (already done when pipelined)
+    if (!pop->pipeline) pool_run(pop->pool, breed_offspring_task, &breed_job);
+    phase_end(stats, PHASE_BREED, &mark);
+
+    // Update library every 5 generations (increased frequency for more
+    // diversity), while the ranking still matches pop->programs. Pipelined,
+    // the update learned during this generation's evaluation goes live now
+    // that breeding is done, and this generation is snapshotted for the next
+    if (pop->pipeline) {
+        if (pop->library_snapshot) {
+            library_snapshot_install(pop, pop->library_snapshot);
+            library_snapshot_destroy(pop->library_snapshot);
+            pop->library_snapshot = NULL;
+        }
+        if (pop->generation % 5 == 0) pop->library_snapshot = library_snapshot_take(pop);
+    } else if (pop->generation % 5 == 0) {
+        library_update(pop);
     }
+    phase_end(stats, PHASE_LIBRARY, &mark);
 
-    return copy;
+    // Replace population
+    stats->node_allocs = pop_node_allocs(pop) - stats->node_allocs;
+    for (int i = 0; i < pop->pop_size; i++) {
+        prog_destroy(pop->programs[i]);
+    }
+    pop->next_programs = pop->programs;
+    pop->programs = new_pop;
+    pop->num_ranked = 0;
+    reset_arenas(pop, parent_parity);
+    pop->steady_ready = 0;
+    pop->steady_offspring = 0;
+    phase_end(stats, PHASE_REPLACE, &mark);
+
+    stats->evaluations = pop->pop_size;
+    stats_end(pop, &mark);
+    pop->generation++;
 }
 
-// Inject library calls into tree
-static void inject_library_calls(Node* node, Population* pop, int depth) {
-    if (!node || !pop || pop->library_size == 0) return;
-    if (depth > MAX_DEPTH) return;
+// Steady-state evolution
+//
+// Slots are guarded by one-byte spinlocks, held only while a parent is
+// copied or a slot's program is swapped out. Tournaments read fitness from
+// slot_fitness without locking, so selection never touches a program that
+// another worker may be about to free.
 
-    // Get node's return type
-    OpInfo* info = get_op_info(node->op);
-    if (!info) return;
+typedef struct {
+    Population* pop;
+    FitnessFn fitness_fn;
+    void* data;
+    ThreadData* threads;
+    int offspring;
+    int next;               // Next offspring number, claimed atomically
+    int base_generation;
+    int base_offspring;     // pop->steady_offspring when the call started
+} SteadyJob;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
 
-    // 5% chance to replace this node with a library call
-    // Only replace INT-returning nodes (library entries return INT)
-    if (rand() % 20 == 0 && info->return_type == TYPE_INT) {
-        int lib_idx = rand() % pop->library_size;
-        LibraryEntry* lib = &pop->library[lib_idx];
+static void slot_lock(Population* pop, int i) {
+    if (!__atomic_exchange_n(&pop->slot_locks[i], 1, __ATOMIC_ACQUIRE)) return;
+    double start = now_seconds();
+    do {
+        while (__atomic_load_n(&pop->slot_locks[i], __ATOMIC_RELAXED)) cpu_relax();
+    } while (__atomic_exchange_n(&pop->slot_locks[i], 1, __ATOMIC_ACQUIRE));
+    lock_wait_add(&pop->slot_wait_ns, &pop->lock_contentions, start);
+}
 
-        if (lib->num_params > 0) {
-            // Create parameterized function call
-            node->op = OP_FUNC_CALL;
-            node->value = lib_idx;
+static void slot_unlock(Population* pop, int i) {
+    __atomic_store_n(&pop->slot_locks[i], 0, __ATOMIC_RELEASE);
+}
 
-            // Destroy old children
-            for (int i = 0; i < node->num_children; i++) {
-                node_destroy(node->children[i]);
-            }
+static float load_fitness(float* f) {
+    float v;
+    __atomic_load(f, &v, __ATOMIC_RELAXED);
+    return v;
+}
 
-            // Create random argument expressions
-            node->num_children = lib->num_params;
-            for (int i = 0; i < lib->num_params; i++) {
-                node->children[i] = create_random_tree(depth + 1, TYPE_INT, pop->num_inputs);
-            }
-        } else {
-            // Non-parameterized library call
-            node->op = OP_LIBRARY;
-            node->value = lib_idx;
-            // Destroy children since library is a terminal
-            for (int i = 0; i < node->num_children; i++) {
-                node_destroy(node->children[i]);
-            }
-            node->num_children = 0;
-        }
+static void store_fitness(float* f, float v) {
+    __atomic_store(f, &v, __ATOMIC_RELAXED);
+}
 
-        lib->uses++;
-        return;
+// Tournament over slots: the fittest of tournament_size random picks, or
+// with `worst` the least fit (NaN counts as least fit)
+static int steady_tournament(Population* pop, int worst) {
+    int pick = random_int(pop->pop_size);
+    float pick_fitness = load_fitness(&pop->slot_fitness[pick]);
+    for (int i = 1; i < pop->tournament_size; i++) {
+        int idx = random_int(pop->pop_size);
+        float f = load_fitness(&pop->slot_fitness[idx]);
+        int wins = worst ? (isnan(f) || f < pick_fitness) : (isnan(pick_fitness) ? !isnan(f) : f > pick_fitness);
+        if (wins) {
+            pick = idx;
+            pick_fitness = f;
+        }
     }
+    return pick;
+}
 
-    // Recursively process children
-    for (int i = 0; i < node->num_children; i++) {
-        inject_library_calls(node->children[i], pop, depth + 1);
+// 70% crossover, 30% mutation, as in evolve_generation
+static Program* steady_breed(Population* pop) {
+    if (random_int(10) < 7) {
+        int a = steady_tournament(pop, 0);
+        int b = steady_tournament(pop, 0);
+        int lo = a < b ? a : b;
+        int hi = a < b ? b : a;
+        slot_lock(pop, lo);
+        if (hi != lo) slot_lock(pop, hi);
+        Program* child = evolve_crossover(pop->programs[a], pop->programs[b]);
+        if (hi != lo) slot_unlock(pop, hi);
+        slot_unlock(pop, lo);
+        return child;
     }
+    int p = steady_tournament(pop, 0);
+    slot_lock(pop, p);
+    Program* child = evolve_mutate(pop->programs[p], pop);
+    slot_unlock(pop, p);
+    return child;
 }
 
-Program* evolve_mutate(Program* parent, Population* pop) {
-    Program* child = calloc(1, sizeof(Program));
-    int num_inputs = pop ? pop->num_inputs : MAX_INPUTS;
-    child->root = mutate_tree(node_copy(parent->root), 0, num_inputs);
-
-    // Possibly inject library calls
-    if (pop && pop->library_size > 0 && rand() % 3 == 0) {
-        inject_library_calls(child->root, pop, 0);
+static void steady_update_best(Population* pop, Program* child) {
+    if (!(child->fitness > load_fitness(&pop->best_fitness))) return;
+    mutex_lock_counted(&pop->lock, &pop->lock_wait_ns, &pop->lock_contentions);
+    if (child->fitness > pop->best_fitness) {
+        prog_destroy(pop->best);
+        pop->best = prog_copy(child);
+        store_fitness(&pop->best_fitness, child->fitness);
     }
+    pthread_mutex_unlock(&pop->lock);
+}
 
-    child->depth = node_depth(child->root);
-    child->size = node_size(child->root);
-    child->fitness = -INFINITY;
-    return child;
+static void steady_replace(Population* pop, Program* child) {
+    int loser = steady_tournament(pop, 1);
+    slot_lock(pop, loser);
+    Program* old = pop->programs[loser];
+    pop->programs[loser] = child;
+    store_fitness(&pop->slot_fitness[loser], child->fitness);
+    slot_unlock(pop, loser);
+    prog_destroy(old);
 }
 
-// Crossover: swap random subtrees
-static Node* get_random_node(Node* node, int* count) {
-    if (!node) return NULL;
-    if (rand() % (++(*count)) == 0) {
-        return node;
-    }
-    for (int i = 0; i < node->num_children; i++) {
-        Node* result = get_random_node(node->children[i], count);
-        if (result) return result;
+// Pool task: breed, evaluate and replace until the offspring budget is
+// spent. Offspring n belongs to generation base + (base_offspring + n) /
+// pop_size and is scored on that generation's evaluation stream.
+static void steady_state_task(void* arg, int worker, int num_workers) {
+    (void)num_workers;
+    SteadyJob* job = (SteadyJob*)arg;
+    Population* pop = job->pop;
+    ThreadData* td = &job->threads[worker];
+    memset(td, 0, sizeof(*td));
+    double start = now_seconds();
+    uint64_t nodes = gp_nodes_executed();
+
+    for (;;) {
+        int n = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (n >= job->offspring) break;
+        int k = job->base_offspring + n;
+        int gen = job->base_generation + k / pop->pop_size;
+        int idx = k % pop->pop_size;
+
+        gp_seed(generation_stream(pop, STREAM_STEADY, gen, idx));
+        Program* child = steady_breed(pop);
+        finish_offspring(pop, child);
+        child->fitness = evaluate_cached(pop, child, job->fitness_fn, job->data,
+                                         generation_stream(pop, STREAM_EVAL, gen, 0),
+                                         fitness_cache_tag(pop, gen), idx, td);
+        td->programs++;
+        steady_update_best(pop, child);
+        steady_replace(pop, child);
     }
-    return node;
+
+    td->nodes = gp_nodes_executed() - nodes;
+    td->busy = now_seconds() - start;
 }
 
-static void replace_node(Node* target, Node* source) {
-    // Destroy old children
-    for (int i = 0; i < target->num_children; i++) {
-        node_destroy(target->children[i]);
+// Put the population in steady-state form: programs on the heap (slots are
+// freed one at a time, which the generation arenas can't do), each with a
+// current fitness mirrored in slot_fitness
+static void steady_prepare(Population* pop, FitnessFn fitness_fn, void* data, ThreadData* threads) {
+    if (!pop->slot_locks) {
+        pop->slot_locks = calloc(pop->pop_size, sizeof(uint8_t));
+        pop->slot_fitness = calloc(pop->pop_size, sizeof(float));
     }
 
-    // Copy new data
-    target->op = source->op;
-    target->type = source->type;
-    target->value = source->value;
-    target->num_children = source->num_children;
-    for (int i = 0; i < source->num_children; i++) {
-        target->children[i] = node_copy(source->children[i]);
+    if (!pop->programs[0]) {
+        BreedJob init_job = {pop, pop->programs, pop->pop_size, -1, 0};
+        pool_run(pop->pool, create_initial_task, &init_job);
+    } else {
+        for (int i = 0; i < pop->pop_size; i++) {
+            Program* prog = pop->programs[i];
+            if (prog && prog->root && prog->root->alloc == NODE_ARENA) {
+                pop->programs[i] = prog_copy(prog);
+                prog_destroy(prog);
+            }
+        }
+        reset_arenas(pop, 0);
+        reset_arenas(pop, 1);
     }
-}
 
-static Node* crossover_trees(Node* p1, Node* p2) {
-    if (!p1 || !p2) return node_copy(p1);
-
-    Node* child = node_copy(p1);
+    evaluate_population(pop, fitness_fn, data, threads);
+    for (int i = 0; i < pop->pop_size; i++) {
+        pop->slot_fitness[i] = rank_fitness(pop->programs, i);
+    }
 
-    // Find random crossover point in child
-    int count = 0;
-    Node* cross_point = get_random_node(child, &count);
+    // Children only ever update pop->best, so start it from the population
+    pop_rank(pop);
+    Program* top = pop->programs[pop->ranking[0]];
+    if (top) steady_update_best(pop, top);
+    pop->steady_ready = 1;
+}
 
-    if (cross_point) {
-        // Replace with subtree from p2
-        count = 0;
-        Node* donor = get_random_node(p2, &count);
-        if (donor) {
-            replace_node(cross_point, donor);
+void evolve_steady_state(Population* pop, FitnessFn fitness_fn, void* data, int num_inputs, int offspring) {
+    pop->num_inputs = num_inputs;
+    int num_threads = pool_size(pop->pool);
+    ThreadData thread_data[num_threads];
+    GenerationStats* stats = &pop->stats;
+    PhaseMark mark;
+    stats_begin(pop, &mark);
+    stats->evaluations = 0;
+
+    uint64_t prepare_hits = 0, prepare_misses = 0, prepare_nodes = 0;
+    if (!pop->steady_ready) {
+        steady_prepare(pop, fitness_fn, data, thread_data);
+        stats->evaluations += pop->pop_size;
+        for (int i = 0; i < num_threads; i++) {
+            prepare_hits += thread_data[i].cache_hits;
+            prepare_misses += thread_data[i].cache_misses;
+            prepare_nodes += thread_data[i].nodes;
         }
     }
+    phase_end(stats, PHASE_INIT, &mark);
+
+    // Breeding, evaluation and replacement are interleaved per offspring and
+    // all charged to PHASE_EVAL
+    SteadyJob job = {pop, fitness_fn, data, thread_data, offspring > 0 ? offspring : 0, 0,
+                     pop->generation, pop->steady_offspring};
+    double loop_start = now_seconds();
+    pool_run(pop->pool, steady_state_task, &job);
+    double loop_time = now_seconds() - loop_start;
+    phase_end(stats, PHASE_EVAL, &mark);
+
+    stats_collect_threads(stats, thread_data, num_threads, loop_time);
+    stats->evaluations += job.offspring;
+    stats->cache_hits += prepare_hits;
+    stats->cache_misses += prepare_misses;
+    stats->nodes_executed += prepare_nodes;
+
+    // Every pop_size offspring make a generation
+    int old_generation = pop->generation;
+    int total = pop->steady_offspring + job.offspring;
+    pop->generation += total / pop->pop_size;
+    pop->steady_offspring = total % pop->pop_size;
 
-    return child;
-}
+    float total_fitness = 0;
+    float worst_fitness = INFINITY;
+    uint64_t total_size = 0;
+    int max_size = 0;
+    for (int i = 0; i < pop->pop_size; i++) {
+        total_fitness += pop->programs[i]->fitness;
+        float f = rank_fitness(pop->programs, i);
+        if (f < worst_fitness) worst_fitness = f;
+        total_size += pop->programs[i]->size;
+        if (pop->programs[i]->size > max_size) max_size = pop->programs[i]->size;
+    }
+    pop->avg_fitness = total_fitness / pop->pop_size;
+    stats->worst_fitness = worst_fitness;
+    stats->mean_size = (double)total_size / pop->pop_size;
+    stats->max_size = max_size;
+    phase_end(stats, PHASE_REDUCE, &mark);
+
+    pop_rank(pop);
+    stats->best_fitness = rank_fitness(pop->programs, pop->ranking[0]);
+    phase_end(stats, PHASE_RANK, &mark);
+
+    // Library learning on the generational schedule (every 5th generation)
+    if ((pop->generation + 4) / 5 != (old_generation + 4) / 5) {
+        library_update(pop);
+    }
+    phase_end(stats, PHASE_LIBRARY, &mark);
 
-Program* evolve_crossover(Program* p1, Program* p2) {
-    Program* child = calloc(1, sizeof(Program));
-    child->root = crossover_trees(p1->root, p2->root);
-    child->depth = node_depth(child->root);
-    child->size = node_size(child->root);
-    child->fitness = -INFINITY;
-    return child;
+    stats->node_allocs = pop_node_allocs(pop) - stats->node_allocs;
+    stats_end(pop, &mark);
 }
 
-// Simplification: remove redundant nodes
-void evolve_simplify(Program* prog) {
-    // TODO: Implement simplification passes
-    // For now, just update metadata
-    if (prog && prog->root) {
-        prog->depth = node_depth(prog->root);
-        prog->size = node_size(prog->root);
-    }
-}
+// Copy a tree with LIB/FUNC_CALL nodes replaced by the library bodies they
+// call (FUNC_CALL arguments substituted for PARAM nodes), so the program no
+// longer depends on pop's library. An argument is copied to each use of its
+// parameter only if that is invisible: no side effects, and memory reads
+// only of cells that neither the body nor the other arguments write. Any
+// other argument must run exactly once, in order, as it does under
+// execute_node. The last such arguments can run in place of their
+// parameters when the body reads each once, in order, before doing
+// anything else impure. The rest are bound to memory cells that neither
+// the program nor the library entries it reaches touch: ADD(MEM_WRITE cell
+// (arg), body) evaluates the argument first and adds 0, and its PARAM uses
+// read the cell. A cell is free again once its body is built, so only calls
+// nested in the body or the arguments need distinct cells. With no cell
+// left the call is kept as a FUNC_CALL.
 
-// Thread data for parallel fitness evaluation
 typedef struct {
     Population* pop;
-    float (*fitness_fn)(Program*, void*);
-    void* data;
-    int start_idx;
-    int end_idx;
-    float partial_fitness;
-} ThreadData;
-
-// Worker thread for fitness evaluation
-static void* evaluate_fitness_worker(void* arg) {
-    ThreadData* td = (ThreadData*)arg;
-    td->partial_fitness = 0.0f;
-
-    for (int i = td->start_idx; i < td->end_idx; i++) {
-        if (td->pop->programs[i]) {
-            td->pop->programs[i]->fitness = td->fitness_fn(td->pop->programs[i], td->data);
-            td->partial_fitness += td->pop->programs[i]->fitness;
-
-            // Check for best (with lock)
-            pthread_mutex_lock(&td->pop->lock);
-            if (td->pop->programs[i]->fitness > td->pop->best_fitness) {
-                prog_destroy(td->pop->best);
-                td->pop->best = prog_copy(td->pop->programs[i]);
-                td->pop->best_fitness = td->pop->programs[i]->fitness;
-            }
-            pthread_mutex_unlock(&td->pop->lock);
-        }
+    unsigned free_cells;                // Bit k: memory[k] is free for a binding
+    unsigned lib_used[MAX_LIBRARY];     // Cells each entry's body reads or writes,
+    unsigned lib_written[MAX_LIBRARY];  // including the entries it calls
+} InlineState;
+
+// Cells a tree reads or writes (used) and writes (written), counting the
+// bodies of the library entries it calls
+static void tree_cells(const InlineState* st, Node* node, unsigned* used, unsigned* written) {
+    if (!node) return;
+    if ((node->op == OP_MEM_READ || node->op == OP_MEM_WRITE) && node->value >= 0 &&
+        node->value < MAX_MEMORY) {
+        *used |= 1u << node->value;
+        if (node->op == OP_MEM_WRITE) *written |= 1u << node->value;
+    }
+    if ((node->op == OP_LIBRARY || node->op == OP_FUNC_CALL) && st->pop && node->value >= 0 &&
+        node->value < st->pop->library_size) {
+        *used |= st->lib_used[node->value];
+        *written |= st->lib_written[node->value];
     }
+    for (int i = 0; i < node->num_children; i++) tree_cells(st, node->children[i], used, written);
+}
 
-    return NULL;
+// Whether an inlined argument may be evaluated any number of times, at any
+// point in the body: no side effects, and no reads of the cells in written
+static int arg_substitutable(Node* node, unsigned written) {
+    if (!node) return 1;
+    switch (node->op) {
+        case OP_OUTPUT:
+        case OP_MEM_WRITE:
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+            return 0;
+        case OP_MEM_READ:
+            if (node->value >= 0 && node->value < MAX_MEMORY && (written & (1u << node->value))) return 0;
+            break;
+        default:
+            break;
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        if (!arg_substitutable(node->children[i], written)) return 0;
+    }
+    return 1;
 }
 
-// Tournament selection
-static Program* tournament_select(Population* pop) {
-    Program* best = NULL;
-    float best_fitness = -INFINITY;
+// The PARAM reads a body makes unconditionally, in order, before anything
+// with side effects, memory reads or calls. Returns 1 once the prefix ends.
+#define LEADING_PARAMS 64
 
-    for (int i = 0; i < TOURNAMENT_SIZE; i++) {
-        int idx = rand() % POP_SIZE;
-        if (pop->programs[idx] && pop->programs[idx]->fitness > best_fitness) {
-            best = pop->programs[idx];
-            best_fitness = pop->programs[idx]->fitness;
-        }
+// No PARAM reads and nothing a reordered argument could notice
+static int node_quiet(Node* node) {
+    if (!node) return 1;
+    switch (node->op) {
+        case OP_PARAM:
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+        case OP_MEM_READ:
+        case OP_OUTPUT:
+        case OP_MEM_WRITE:
+            return 0;
+        default:
+            break;
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        if (!node_quiet(node->children[i])) return 0;
     }
+    return 1;
+}
 
-    return best;
+static int leading_params(Node* node, int* params, int* count) {
+    if (!node) return 0;
+    switch (node->op) {
+        case OP_PARAM:
+            if (*count == LEADING_PARAMS) return 1;
+            params[(*count)++] = node->value;
+            return 0;
+        case OP_LIBRARY:
+        case OP_FUNC_CALL:
+        case OP_MEM_READ:
+            return 1;
+        default:
+            break;
+    }
+    int first = node->op == OP_IF ? 1 : node->op == OP_IF_GT ? 2 : node->num_children;
+    for (int i = 0; i < first; i++) {
+        if (leading_params(node->children[i], params, count)) return 1;
+    }
+    if (node->op == OP_OUTPUT || node->op == OP_MEM_WRITE) return 1;
+    // A branch might not run, so the prefix ends at one that isn't quiet
+    for (int i = first; i < node->num_children; i++) {
+        if (!node_quiet(node->children[i])) return 1;
+    }
+    return 0;
 }
 
-// Evolution
-void evolve_generation(Population* pop, float (*fitness_fn)(Program*, void*), void* data, int num_inputs) {
-    // Store num_inputs in population
-    pop->num_inputs = num_inputs;
+static int param_uses(Node* node, int p) {
+    if (!node) return 0;
+    int uses = node->op == OP_PARAM && node->value == p;
+    for (int i = 0; i < node->num_children; i++) uses += param_uses(node->children[i], p);
+    return uses;
+}
 
-    // Initialize population if empty
-    if (!pop->programs[0]) {
-        for (int i = 0; i < POP_SIZE; i++) {
-            pop->programs[i] = prog_create_random(5, num_inputs);
-        }
+static int has_library_call(Node* node) {
+    if (!node) return 0;
+    if (node->op == OP_LIBRARY) return 1;
+    for (int i = 0; i < node->num_children; i++) {
+        if (has_library_call(node->children[i])) return 1;
     }
+    return 0;
+}
 
-    // Evaluate fitness in parallel
-    int num_threads = 12;  // Number of CPU cores
-    pthread_t threads[12];
-    ThreadData thread_data[12];
-
-    int chunk_size = POP_SIZE / num_threads;
-    int remainder = POP_SIZE % num_threads;
+static Node* inline_node(Node* node, InlineState* st, Node** args, int num_args, int depth) {
+    if (!node) return NULL;
 
-    for (int i = 0; i < num_threads; i++) {
-        thread_data[i].pop = pop;
-        thread_data[i].fitness_fn = fitness_fn;
-        thread_data[i].data = data;
-        thread_data[i].start_idx = i * chunk_size;
-        thread_data[i].end_idx = (i + 1) * chunk_size;
+    if (node->op == OP_PARAM && args) {
+        if (node->value >= 0 && node->value < num_args) return node_copy(args[node->value]);
+        return node_create(OP_CONST, 0);
+    }
 
-        // Last thread handles remainder
-        if (i == num_threads - 1) {
-            thread_data[i].end_idx += remainder;
+    if (node->op == OP_LIBRARY || node->op == OP_FUNC_CALL) {
+        Population* pop = st->pop;
+        int idx = node->value;
+        if (!pop || idx < 0 || idx >= pop->library_size || depth >= MAX_CALL_DEPTH) {
+            return node_create(OP_CONST, 0);
+        }
+        LibraryEntry* entry = &pop->library[idx];
+        if (node->op == OP_LIBRARY) {
+            return inline_node(entry->tree, st, args, num_args, depth + 1);
         }
 
-        pthread_create(&threads[i], NULL, evaluate_fitness_worker, &thread_data[i]);
-    }
+        Node* call_args[MAX_CHILDREN];
+        unsigned arg_written[MAX_CHILDREN];
+        int n = node->num_children < entry->num_params ? node->num_children : entry->num_params;
+        unsigned used = 0, written = st->lib_written[idx];
+        for (int i = 0; i < n; i++) {
+            call_args[i] = inline_node(node->children[i], st, args, num_args, depth);
+            arg_written[i] = 0;
+            tree_cells(st, call_args[i], &used, &arg_written[i]);
+            written |= arg_written[i];
+        }
 
-    // Wait for all threads and accumulate fitness
-    float total_fitness = 0;
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
-        total_fitness += thread_data[i].partial_fitness;
-    }
-    pop->avg_fitness = total_fitness / POP_SIZE;
+        // The last arguments to bind can instead run in place of their
+        // parameters, if the body reads each once, in argument order, before
+        // doing anything their effects could be reordered against. LIB
+        // calls in the body would read them again through the same args.
+        int in_place[MAX_CHILDREN] = {0};
+        int reads[LEADING_PARAMS], num_reads = 0;
+        if (!has_library_call(entry->tree)) leading_params(entry->tree, reads, &num_reads);
+        int next_read = num_reads;
+        for (int i = n - 1; i >= 0; i--) {
+            if (arg_substitutable(call_args[i], written)) continue;
+            int r = 0;
+            while (r < next_read && reads[r] != i) r++;
+            if (r == next_read || param_uses(entry->tree, i) != 1) break;
+            in_place[i] = 1;
+            next_read = r;
+        }
 
-    // Create new generation
-    Program* new_pop[POP_SIZE];
+        // A binding's cell must survive the arguments after it, which may
+        // reuse cells their own inlined calls have given back
+        int cell_of[MAX_CHILDREN];
+        unsigned later[MAX_CHILDREN + 1];
+        later[n] = 0;
+        for (int i = n - 1; i >= 0; i--) later[i] = later[i + 1] | arg_written[i];
+        unsigned bound = 0;
+        int fits = 1;
+        for (int i = 0; i < n && fits; i++) {
+            cell_of[i] = -1;
+            if (in_place[i] || arg_substitutable(call_args[i], written)) continue;
+            unsigned cells = st->free_cells & ~bound & ~later[i + 1];
+            if (!cells) fits = 0;
+            else cell_of[i] = __builtin_ctz(cells);
+            bound |= cells & -cells;
+        }
 
-    // Elitism: keep best programs
-    for (int i = 0; i < ELITE_SIZE; i++) {
-        // Find best in population
-        Program* best = pop->programs[0];
-        int best_idx = 0;
-        for (int j = 1; j < POP_SIZE; j++) {
-            if (pop->programs[j] && pop->programs[j]->fitness > best->fitness) {
-                best = pop->programs[j];
-                best_idx = j;
+        if (!fits) {
+            Node* call = node_create(OP_FUNC_CALL, idx);
+            call->num_children = node->num_children;
+            for (int i = 0; i < node->num_children; i++) {
+                call->children[i] = i < n ? call_args[i]
+                                          : inline_node(node->children[i], st, args, num_args, depth);
             }
+            return call;
         }
-        new_pop[i] = prog_copy(best);
-        pop->programs[best_idx]->fitness = -INFINITY;  // Mark as used
-    }
 
-    // Restore fitness
-    for (int i = 0; i < POP_SIZE; i++) {
-        if (pop->programs[i] && pop->programs[i]->fitness == -INFINITY) {
-            pop->programs[i]->fitness = fitness_fn(pop->programs[i], data);
+        // Arguments are evaluated in order, so bindings nest left to right
+        Node* writes[MAX_CHILDREN];
+        int num_writes = 0;
+        st->free_cells &= ~bound;
+        for (int i = 0; i < n; i++) {
+            if (cell_of[i] < 0) continue;
+            Node* write = node_create(OP_MEM_WRITE, cell_of[i]);
+            write->num_children = 1;
+            write->children[0] = call_args[i];
+            writes[num_writes++] = write;
+            call_args[i] = node_create(OP_MEM_READ, cell_of[i]);
         }
-    }
 
-    // Generate offspring
-    for (int i = ELITE_SIZE; i < POP_SIZE; i++) {
-        if (rand() % 10 < 7) {  // 70% crossover
-            Program* p1 = tournament_select(pop);
-            Program* p2 = tournament_select(pop);
-            new_pop[i] = evolve_crossover(p1, p2);
-        } else {  // 30% mutation
-            Program* parent = tournament_select(pop);
-            new_pop[i] = evolve_mutate(parent, pop);
+        Node* body = inline_node(entry->tree, st, call_args, n, depth + 1);
+        st->free_cells |= bound;
+        for (int i = 0; i < n; i++) {
+            node_destroy(call_args[i]);
         }
+        for (int i = num_writes - 1; i >= 0; i--) {
+            Node* add = node_create(OP_ADD, 0);
+            add->num_children = 2;
+            add->children[0] = writes[i];
+            add->children[1] = body;
+            body = add;
+        }
+        return body;
     }
 
-    // Replace population
-    for (int i = 0; i < POP_SIZE; i++) {
-        prog_destroy(pop->programs[i]);
-        pop->programs[i] = new_pop[i];
+    Node* copy = node_create(node->op, node->value);
+    copy->num_children = node->num_children;
+    for (int i = 0; i < node->num_children; i++) {
+        copy->children[i] = inline_node(node->children[i], st, args, num_args, depth);
     }
+    return copy;
+}
 
-    // Update library every 5 generations (increased frequency for more diversity)
-    if (pop->generation % 5 == 0) {
-        library_update(pop);
+Node* node_inline_library(Node* node, Population* pop) {
+    InlineState st = {pop, 0, {0}, {0}};
+
+    // Entries may call each other (even in cycles), so spread the cells
+    // along calls until nothing changes
+    int changed = 1;
+    while (pop && changed) {
+        changed = 0;
+        for (int i = 0; i < pop->library_size; i++) {
+            unsigned used = st.lib_used[i], written = st.lib_written[i];
+            tree_cells(&st, pop->library[i].tree, &used, &written);
+            if (used != st.lib_used[i] || written != st.lib_written[i]) {
+                st.lib_used[i] = used;
+                st.lib_written[i] = written;
+                changed = 1;
+            }
+        }
     }
 
-    pop->generation++;
+    unsigned used = 0, written = 0;
+    tree_cells(&st, node, &used, &written);
+    st.free_cells = ~used & ((1u << MAX_MEMORY) - 1);
+    return inline_node(node, &st, NULL, 0, 0);
 }
 
 // Library learning helpers
@@ -928,8 +4491,10 @@ void library_add(Population* pop, Node* pattern, const char* name, float fitness
         }
         // Replace it
         node_destroy(pop->library[min_idx].tree);
+        bytecode_destroy(pop->library[min_idx].code);
         strncpy(pop->library[min_idx].name, name, 31);
         pop->library[min_idx].tree = parameterized;
+        pop->library[min_idx].code = bytecode_compile(parameterized);
         pop->library[min_idx].uses = 1;
         pop->library[min_idx].avg_fitness = fitness;
         pop->library[min_idx].num_params = num_params;
@@ -941,6 +4506,7 @@ void library_add(Population* pop, Node* pattern, const char* name, float fitness
         LibraryEntry* entry = &pop->library[pop->library_size++];
         strncpy(entry->name, name, 31);
         entry->tree = parameterized;
+        entry->code = bytecode_compile(parameterized);
         entry->uses = 1;
         entry->avg_fitness = fitness;
         entry->num_params = num_params;
@@ -948,6 +4514,7 @@ void library_add(Population* pop, Node* pattern, const char* name, float fitness
             entry->param_types[i] = TYPE_INT;
         }
     }
+    pop->library_version++;
 }
 
 // Score pattern quality
@@ -977,43 +4544,49 @@ static float pattern_quality(Node* pattern, Program** sorted, int num_programs)
     return score;
 }
 
-// Update library from elite programs
-void library_update(Population* pop) {
-    // Sort programs by fitness
-    Program* sorted[POP_SIZE];
-    for (int i = 0; i < POP_SIZE; i++) {
-        sorted[i] = pop->programs[i];
-    }
-    for (int i = 0; i < POP_SIZE - 1; i++) {
-        for (int j = i + 1; j < POP_SIZE; j++) {
-            if (sorted[j]->fitness > sorted[i]->fitness) {
-                Program* tmp = sorted[i];
-                sorted[i] = sorted[j];
-                sorted[j] = tmp;
-            }
-        }
-    }
+typedef struct {
+    Node* pattern;
+    float quality;
+    int order;          // Extraction order, breaks ties
+} ScoredPattern;
+
+static int compare_pattern_quality(const void* a, const void* b) {
+    const ScoredPattern* pa = a;
+    const ScoredPattern* pb = b;
+    if (pa->quality != pb->quality) return pa->quality < pb->quality ? 1 : -1;
+    return pa->order - pb->order;
+}
+
+typedef struct {
+    int idx;
+    float score;
+} LibScore;
+
+static int compare_lib_score(const void* a, const void* b) {
+    const LibScore* la = a;
+    const LibScore* lb = b;
+    if (la->score != lb->score) return la->score < lb->score ? 1 : -1;
+    return la->idx - lb->idx;
+}
 
+// Learn from the best programs of a generation (sorted[0] is the best).
+// Only touches pop's library, so it can run on a shadow population.
+static void library_learn(Population* pop, Program** sorted, int num_sorted, float worst_fitness) {
     // Fitness threshold: only extract from top 20% performers
-    float fitness_threshold = sorted[0]->fitness - (sorted[0]->fitness - sorted[POP_SIZE-1]->fitness) * 0.2;
+    float fitness_threshold = sorted[0]->fitness - (sorted[0]->fitness - worst_fitness) * 0.2;
 
     // Extract subtrees from elite programs above threshold
     Node** candidates = malloc(sizeof(Node*) * 200);
     int num_candidates = 0;
 
-    int num_elite = ELITE_SIZE < 5 ? ELITE_SIZE : 5;
-    for (int i = 0; i < num_elite; i++) {
+    int num_elite = pop->elite_size < 5 ? pop->elite_size : 5;
+    for (int i = 0; i < num_elite && i < num_sorted; i++) {
         if (sorted[i] && sorted[i]->root && sorted[i]->fitness >= fitness_threshold) {
             extract_subtrees(sorted[i]->root, &candidates, &num_candidates, 5, 12);
         }
     }
 
     // Score and filter candidates
-    typedef struct {
-        Node* pattern;
-        float quality;
-    } ScoredPattern;
-
     ScoredPattern* scored = malloc(sizeof(ScoredPattern) * num_candidates);
     int num_scored = 0;
 
@@ -1031,26 +4604,19 @@ void library_update(Population* pop) {
         if (library_too_similar(pop, candidate, 0.7)) continue;
 
         // Score quality
-        float quality = pattern_quality(candidate, sorted, POP_SIZE);
+        float quality = pattern_quality(candidate, sorted, num_sorted);
 
         // Only keep if quality is positive
         if (quality > 0) {
             scored[num_scored].pattern = candidate;
             scored[num_scored].quality = quality;
+            scored[num_scored].order = num_scored;
             num_scored++;
         }
     }
 
     // Sort by quality
-    for (int i = 0; i < num_scored - 1; i++) {
-        for (int j = i + 1; j < num_scored; j++) {
-            if (scored[j].quality > scored[i].quality) {
-                ScoredPattern tmp = scored[i];
-                scored[i] = scored[j];
-                scored[j] = tmp;
-            }
-        }
-    }
+    qsort(scored, num_scored, sizeof(ScoredPattern), compare_pattern_quality);
 
     // Add top 5 patterns (increased from 3 for more diversity)
     int added = 0;
@@ -1067,11 +4633,6 @@ void library_update(Population* pop) {
     // Competitive library: prune low-value entries
     if (pop->library_size >= MAX_LIBRARY) {
         // Score each library entry
-        typedef struct {
-            int idx;
-            float score;
-        } LibScore;
-
         LibScore* lib_scores = malloc(sizeof(LibScore) * pop->library_size);
         for (int i = 0; i < pop->library_size; i++) {
             // Score = uses * quality
@@ -1081,28 +4642,26 @@ void library_update(Population* pop) {
         }
 
         // Sort by score
-        for (int i = 0; i < pop->library_size - 1; i++) {
-            for (int j = i + 1; j < pop->library_size; j++) {
-                if (lib_scores[j].score > lib_scores[i].score) {
-                    LibScore tmp = lib_scores[i];
-                    lib_scores[i] = lib_scores[j];
-                    lib_scores[j] = tmp;
-                }
-            }
-        }
+        qsort(lib_scores, pop->library_size, sizeof(LibScore), compare_lib_score);
 
-        // Remove bottom 25%
+        // Remove bottom 25%: mark first, then compact once, so indices stay
+        // valid while removing
         int num_to_remove = pop->library_size / 4;
+        int remove[MAX_LIBRARY] = {0};
         for (int i = 0; i < num_to_remove; i++) {
-            int idx = lib_scores[pop->library_size - 1 - i].idx;
-            node_destroy(pop->library[idx].tree);
-
-            // Shift remaining entries
-            for (int j = idx; j < pop->library_size - 1; j++) {
-                pop->library[j] = pop->library[j + 1];
+            remove[lib_scores[pop->library_size - 1 - i].idx] = 1;
+        }
+        int kept = 0;
+        for (int i = 0; i < pop->library_size; i++) {
+            if (remove[i]) {
+                node_destroy(pop->library[i].tree);
+                bytecode_destroy(pop->library[i].code);
+            } else {
+                pop->library[kept++] = pop->library[i];
             }
-            pop->library_size--;
         }
+        pop->library_size = kept;
+        pop->library_version++;
 
         free(lib_scores);
     }
@@ -1112,3 +4671,91 @@ void library_update(Population* pop) {
         pop->library[i].uses = (int)(pop->library[i].uses * 0.98);
     }
 }
+
+static float population_worst_fitness(Population* pop) {
+    float worst_fitness = INFINITY;
+    for (int i = 0; i < pop->pop_size; i++) {
+        float f = rank_fitness(pop->programs, i);
+        if (f < worst_fitness) worst_fitness = f;
+    }
+    return worst_fitness;
+}
+
+// Update library from elite programs, using the ranking of pop->programs
+// (computed here if evolve_generation hasn't already)
+void library_update(Population* pop) {
+    if (pop->num_ranked == 0) pop_rank(pop);
+
+    int num_sorted = pop->num_ranked;
+    Program* sorted[num_sorted];
+    for (int i = 0; i < num_sorted; i++) {
+        sorted[i] = pop->programs[pop->ranking[i]];
+    }
+    library_learn(pop, sorted, num_sorted, population_worst_fitness(pop));
+}
+
+// Library snapshots (pipelined mode). The shadow is a bare Population that
+// only holds a copy of the library; learning into it leaves the live library
+// untouched while offspring are bred from it. Use counts gained after the
+// snapshot are dropped when the shadow is installed.
+struct LibrarySnapshot {
+    Population* shadow;
+    Program** sorted;           // Copies of the ranked programs
+    int num_sorted;
+    float worst_fitness;
+};
+
+static LibrarySnapshot* library_snapshot_take(Population* pop) {
+    if (pop->num_ranked == 0) pop_rank(pop);
+
+    LibrarySnapshot* snap = calloc(1, sizeof(LibrarySnapshot));
+    snap->num_sorted = pop->num_ranked;
+    snap->sorted = malloc(sizeof(Program*) * snap->num_sorted);
+    for (int i = 0; i < snap->num_sorted; i++) {
+        snap->sorted[i] = prog_copy(pop->programs[pop->ranking[i]]);
+    }
+    snap->worst_fitness = population_worst_fitness(pop);
+
+    Population* shadow = calloc(1, sizeof(Population));
+    shadow->elite_size = pop->elite_size;
+    shadow->library_size = pop->library_size;
+    shadow->library_version = pop->library_version;
+    for (int i = 0; i < pop->library_size; i++) {
+        shadow->library[i] = pop->library[i];
+        shadow->library[i].tree = node_copy(pop->library[i].tree);
+        shadow->library[i].code = bytecode_copy(pop->library[i].code);
+    }
+    snap->shadow = shadow;
+    return snap;
+}
+
+static void library_snapshot_learn(LibrarySnapshot* snap) {
+    NodeArena* saved = node_arena_use(NULL);
+    library_learn(snap->shadow, snap->sorted, snap->num_sorted, snap->worst_fitness);
+    node_arena_use(saved);
+}
+
+// Make the shadow's library the live one (it moves out of the snapshot)
+static void library_snapshot_install(Population* pop, LibrarySnapshot* snap) {
+    Population* shadow = snap->shadow;
+    for (int i = 0; i < pop->library_size; i++) {
+        node_destroy(pop->library[i].tree);
+        bytecode_destroy(pop->library[i].code);
+    }
+    memcpy(pop->library, shadow->library, sizeof(LibraryEntry) * shadow->library_size);
+    pop->library_size = shadow->library_size;
+    pop->library_version++;
+    shadow->library_size = 0;
+}
+
+static void library_snapshot_destroy(LibrarySnapshot* snap) {
+    if (!snap) return;
+    for (int i = 0; i < snap->shadow->library_size; i++) {
+        node_destroy(snap->shadow->library[i].tree);
+        bytecode_destroy(snap->shadow->library[i].code);
+    }
+    free(snap->shadow);
+    for (int i = 0; i < snap->num_sorted; i++) prog_destroy(snap->sorted[i]);
+    free(snap->sorted);
+    free(snap);
+}
@@ -2,6 +2,8 @@
 #define GP_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <pthread.h>
 
 // Type system for operations
@@ -71,6 +73,26 @@ typedef enum {
     OP_COUNT
 } OpType;
 
+// Per-opcode execution profile. Built with -DGP_PROFILE, every interpreter
+// counts node executions per OpType into per-thread tables (the batch and
+// bit-sliced paths count one per case). -DGP_PROFILE_CYCLES also charges the
+// bytecode VM's self time, instruction by instruction, to the OpType each
+// instruction was compiled from (IDENT compiles to nothing there). Normal
+// builds count nothing and the queries return zeros.
+#if defined(GP_PROFILE_CYCLES) && !defined(GP_PROFILE)
+#define GP_PROFILE
+#endif
+
+typedef struct {
+    uint64_t count[OP_COUNT];
+    uint64_t cycles[OP_COUNT];  // TSC ticks (ns where there is no TSC)
+} OpProfile;
+
+int gp_profile_enabled(void);                  // 0 = off, 1 = counts, 2 = counts and cycles
+void gp_profile_count(OpType op, uint64_t n);
+void gp_profile_totals(OpProfile* out);        // Every thread since startup (process wide)
+void gp_profile_print(const OpProfile* prof, uint64_t evaluations, FILE* out);
+
 // Maximum tree depth and children
 #define MAX_DEPTH 15  // Increased to allow more complex solutions
 #define MAX_CHILDREN 4
@@ -78,20 +100,53 @@ typedef enum {
 #define MAX_INPUTS 16  // Increased for 11-bit mux and larger problems
 #define MAX_OUTPUTS 8
 #define MAX_MEMORY 8
+#define MAX_CALL_DEPTH 64  // Nested LIB/FUNC_CALL limit (library cycles evaluate to 0)
+
+// Where a node lives, which decides what node_destroy does with it
+typedef enum {
+    NODE_HEAP,              // calloc'd, freed by node_destroy
+    NODE_ARENA,             // Owned by a NodeArena (released with it, not by node_destroy)
+    NODE_SHARED,            // Hash-consed by node_intern: reference counted, never edited
+} NodeAlloc;
 
 // Tree node
 typedef struct Node {
-    OpType op;
-    ValueType type;
+    uint8_t op;             // OpType (packed: large populations hold millions of nodes)
+    uint8_t type;           // ValueType
+    uint8_t num_children;
+    uint8_t alloc;          // NodeAlloc
     int value;              // For OP_CONST, OP_INPUT index, or OP_LIBRARY index
-    int num_children;
     struct Node* children[MAX_CHILDREN];
 } Node;
 
+// Bump-pointer node arena. While an arena is active on a thread, node_create
+// allocates from it and node_destroy leaves its nodes alone; node_arena_reset
+// releases every node at once. A tree is always allocated entirely from one
+// arena or entirely from the heap, except that heap trees may hold shared
+// subtrees (see node_intern).
+typedef struct NodeArena NodeArena;
+
+typedef struct ThreadPool ThreadPool;
+
+// Node allocation counters (process wide)
+typedef struct {
+    uint64_t heap_nodes;      // Nodes allocated with calloc
+    uint64_t heap_frees;      // Nodes released with free
+    uint64_t arena_nodes;     // Nodes bump-allocated from an arena
+    uint64_t arena_chunks;    // Arena chunks obtained from malloc
+    uint64_t arena_resets;    // Whole-arena releases
+    uint64_t shared_nodes;    // Hash-consed nodes alive now (also counted as heap nodes)
+    uint64_t shared_hits;     // Nodes node_intern found already in the table
+} AllocStats;
+
+// Compiled postfix form of a tree (opaque, see prog_compile)
+typedef struct Bytecode Bytecode;
+
 // Library entry (learned patterns / ADF functions)
 typedef struct {
     char name[32];
     Node* tree;
+    Bytecode* code;         // Compiled body, called by LIB/FUNC_CALL instructions
     int uses;               // How many times it's been used successfully
     float avg_fitness;      // Average fitness of programs using it
     int num_params;         // Number of parameters for ADF
@@ -104,27 +159,220 @@ typedef struct {
     float fitness;
     int depth;
     int size;              // Number of nodes
+    uint64_t hash;         // Structural hash of root (see node_hash)
+    Bytecode* code;        // Compiled form of root (NULL = interpret the tree)
 } Program;
 
-// Population
+// Random numbers (xoshiro256**). Every thread has its own generator, and
+// evolve_generation reseeds it from the run seed for each individual, so a
+// run is reproducible whatever the thread count.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+void rng_seed(Rng* rng, uint64_t seed);
+uint64_t rng_next(Rng* rng);
+int rng_int(Rng* rng, int n);                 // Uniform in [0, n)
+float rng_float(Rng* rng);                    // Uniform in [0, 1)
+uint64_t rng_derive(uint64_t seed, uint64_t a, uint64_t b);  // Independent stream seed
+Rng* gp_rng(void);                            // Calling thread's generator
+void gp_seed(uint64_t seed);                  // Reseed the calling thread's generator
+
+// Fitness function. rng is seeded from (run seed, generation) and is the
+// same for every individual in a generation, so all programs see the same
+// episodes; use it instead of rand().
+typedef float (*FitnessFn)(Program* prog, void* data, Rng* rng);
+
+// Hardware performance counters (gp_perf.c, Linux perf_event_open) for the
+// calling thread. Events that can't be opened, e.g. without a PMU in a
+// container, are left out of perf_available and read as 0.
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_COUNT
+} PerfEvent;
+
+extern const char* gp_perf_names[PERF_COUNT];
+
+typedef struct PerfCounters PerfCounters;
+
+PerfCounters* perf_open(void);
+void perf_close(PerfCounters* pc);
+unsigned perf_available(PerfCounters* pc);     // Bit e set = event e is counting
+void perf_read(PerfCounters* pc, uint64_t values[PERF_COUNT]);  // Totals since perf_open
+
+// Per-generation statistics, filled in by evolve_generation
+#define GP_MAX_THREADS 256
+
+// Phases of a generation, in order
+typedef enum {
+    PHASE_INIT,      // Creating the initial population
+    PHASE_EVAL,      // Scoring (pipelined: also breeding and library learning)
+    PHASE_REDUCE,    // Average, worst and size statistics
+    PHASE_RANK,      // pop_rank and best-so-far tracking
+    PHASE_ELITISM,
+    PHASE_BREED,
+    PHASE_LIBRARY,
+    PHASE_REPLACE,   // Releasing the previous generation
+    PHASE_COUNT
+} GenerationPhase;
+
+extern const char* gp_phase_names[PHASE_COUNT];
+
+typedef struct {
+    int generation;                        // Generation these stats describe
+    int num_threads;
+    double eval_time;                      // Wall time of the evaluation phase (s)
+    double thread_busy[GP_MAX_THREADS];    // Time each worker spent scoring programs
+    double thread_idle[GP_MAX_THREADS];    // eval_time minus busy time
+    int thread_programs[GP_MAX_THREADS];   // Programs scored by each worker
+    float best_fitness;                    // Best fitness this generation
+    float worst_fitness;                   // Worst fitness this generation
+    uint64_t cache_hits;                   // Fitness taken from the cache
+    uint64_t cache_misses;                 // Fitness function actually called
+    uint64_t evaluations;                  // Programs scored (cache hits included)
+    double wall_time;                      // Wall time of the whole step (s)
+    double evals_per_sec;                  // evaluations / wall_time
+
+    double phase_wall[PHASE_COUNT];        // Wall time per phase (s)
+    double phase_cpu[PHASE_COUNT];         // Process CPU time per phase, all threads (s)
+    double overlap_breed_time;             // Pipelined: worker time spent breeding during evaluation
+    int overlap_offspring;                 // Pipelined: offspring bred during evaluation
+    double overlap_library_time;           // Pipelined: worker 0's library learning during evaluation
+
+    uint64_t nodes_executed;               // VM instructions / tree nodes run while scoring
+    double nodes_per_sec;                  // nodes_executed / evaluation wall time
+    uint64_t node_allocs;                  // Nodes allocated (heap counts are process wide)
+    double mean_size;                      // Program size over the scored generation
+    int max_size;
+
+    // Time threads spent waiting for locks that were already held (s)
+    double lock_wait;                      // pop->lock
+    double cache_lock_wait;                // Fitness cache shards
+    double slot_lock_wait;                 // Steady state: slot spinlocks
+    uint64_t lock_contentions;             // Acquisitions that had to wait, all of the above
+
+    // PopConfig.perf_counters: events per phase, summed over all workers
+    unsigned perf_available;               // Bit e set = PerfEvent e was counted
+    uint64_t phase_perf[PHASE_COUNT][PERF_COUNT];
+
+    OpProfile ops;                         // -DGP_PROFILE: executions this step, process wide
+
+    // PopConfig.simplify: programs simplified this step and their size
+    uint64_t simplify_programs;
+    uint64_t simplify_nodes_in;            // Before
+    uint64_t simplify_nodes_out;           // After
+    uint64_t dead_nodes;                   // Removed as unreachable given PopConfig.input_ranges
+
+    // PopConfig.share_subtrees: nodes of the new generation counted tree by
+    // tree, and the shared nodes actually behind them (process wide)
+    uint64_t tree_nodes;
+    uint64_t unique_nodes;
+} GenerationStats;
+
+// Inclusive range of values an input (or subtree) can take
+typedef struct {
+    int lo;
+    int hi;
+} ValueRange;
+
+// Fitness memo keyed by structural hash (opaque)
+typedef struct FitnessCache FitnessCache;
+
+// Library learning deferred to the next generation (opaque, pipelined mode)
+typedef struct LibrarySnapshot LibrarySnapshot;
+
+// Population defaults (PopConfig sets the actual sizes at runtime)
 #define POP_SIZE 2000  // Increased for harder problems
 #define TOURNAMENT_SIZE 7
 #define ELITE_SIZE 20  // More elites with larger population
+#define RANK_TOP 32    // Programs kept in fitness order by pop_rank (or elite_size if larger)
 
 typedef struct {
-    Program* programs[POP_SIZE];
+    // Current generation; offspring are built into next_programs and the
+    // two arrays are swapped
+    Program** programs;
+    Program** next_programs;
+    int pop_size;
+    int tournament_size;
+    int elite_size;
+
     LibraryEntry library[MAX_LIBRARY];
     int library_size;
 
     Program* best;
     float best_fitness;
 
+    // Fitness ranking of the last evaluated generation: ranking[0..num_ranked)
+    // are the best programs in order (ties by index), the rest are unordered
+    int* ranking;           // pop_size entries
+    int num_ranked;
+
     // Evolution stats
     int generation;
     float avg_fitness;
     int num_inputs;  // Number of inputs for this problem
+    uint64_t seed;   // Run seed; every random stream is derived from it
+
+    // Persistent worker pool used for every parallel phase
+    ThreadPool* pool;
+    int num_threads;
+
+    // Evaluation scheduling: workers claim eval_batch programs at a time from
+    // a shared counter, optionally walking the population largest-first
+    int eval_batch;
+    int eval_largest_first;
+    int* eval_order;        // Scratch: evaluation order, pop_size entries
+
+    // Programs with the same structural hash share a fitness value within a
+    // generation (any generation for deterministic tasks)
+    FitnessCache* cache;    // NULL = always call the fitness function
+    int deterministic_fitness;
+    int library_version;    // Bumped on every library change
+
+    GenerationStats stats;  // Stats of the most recent generation
+
+    // Offspring of even/odd generations live in alternating node arenas,
+    // one per worker so breeding threads never share an arena
+    NodeArena* arenas[2][GP_MAX_THREADS];
+    int use_arena;   // 0 = plain calloc/free for every node
+    int share_subtrees;     // Hash-cons new programs (PopConfig.share_subtrees)
+    int boolean_ops;        // Random subtrees stay bit-sliceable (PopConfig.boolean_ops)
+    uint64_t arena_allocs;  // Nodes the arenas handed out before their last reset
+
+    // Steady-state mode (see evolve_steady_state): per-slot spinlocks and a
+    // copy of each slot's fitness that tournaments read without locking
+    uint8_t* slot_locks;
+    float* slot_fitness;
+    int steady_ready;       // Programs are heap trees with current fitness
+    int steady_offspring;   // Offspring since the last generation boundary
+
+    // Pipelined generations (see PopConfig.pipeline)
+    int pipeline;
+    float pipeline_threshold;
+    uint8_t* scored;        // Programs of this generation already scored
+    LibrarySnapshot* library_snapshot;  // Learned from during the next evaluation
+
+    PerfCounters* perf[GP_MAX_THREADS];  // Per worker (PopConfig.perf_counters)
+
+    int simplify;                   // SimplifyMode for new programs
+    uint64_t simplify_programs;     // This step (see GenerationStats)
+    uint64_t simplify_nodes_in;
+    uint64_t simplify_nodes_out;
+    uint64_t dead_nodes;
+    ValueRange input_ranges[MAX_INPUTS];    // Declared by the task (PopConfig.input_ranges)
+    int num_input_ranges;
+
+    FILE* stats_json;       // One JSON line per generation (NULL = off)
+    int stats_json_owned;   // Opened by pop_create_config, closed with pop
 
     pthread_mutex_t lock;
+    uint64_t lock_wait_ns;      // Lock waits this step (see GenerationStats.lock_wait)
+    uint64_t slot_wait_ns;
+    uint64_t lock_contentions;
 } Population;
 
 // Operation metadata (for printing/debugging)
@@ -138,20 +386,83 @@ typedef struct {
 
 extern OpInfo op_info[];
 
+// What evolve_simplify is applied to as programs are created
+typedef enum {
+    SIMPLIFY_OFF,
+    SIMPLIFY_EVAL,          // Only the bytecode that gets scored; the genotype is untouched
+    SIMPLIFY_GENOTYPE,      // The tree itself, so offspring inherit the simpler form
+} SimplifyMode;
+
+// Population configuration
+typedef struct {
+    int pop_size;               // Programs per generation
+    int tournament_size;
+    int elite_size;             // Best programs copied unchanged into the next generation
+    int num_threads;            // Worker threads including the caller (0 = CPUs available)
+    int pin_threads;            // Pin each worker, the calling thread included, to its own allowed CPU
+    int eval_batch;             // Programs claimed per grab during evaluation
+    int eval_largest_first;     // Evaluate programs in decreasing size order
+    uint64_t seed;              // Run seed (0 = pick one from the clock)
+    int fitness_cache;          // Skip evaluating structurally identical programs
+    int deterministic_fitness;  // Fitness ignores the Rng, so cache across generations
+    int pipeline;               // Breed offspring while the generation is still being scored
+    float pipeline_threshold;   // Fraction scored before breeding starts
+    int perf_counters;          // Count hardware events per phase (GenerationStats.phase_perf)
+    int simplify;               // SimplifyMode for every new program (env GP_SIMPLIFY=eval|genotype)
+    const ValueRange* input_ranges;  // Values each input can take; simplify prunes branches they rule out
+    int num_input_ranges;       // Inputs past these can be anything
+    int share_subtrees;         // Hash-cons programs so copies share nodes (env GP_SHARE_SUBTREES=1)
+    int boolean_ops;            // Build trees only from ops and constants (-2..1) execute_program_bits runs
+    const char* stats_json;     // Append per-generation stats as JSON lines to this file ("-" = stdout)
+} PopConfig;
+
+// Persistent worker pool. pool_run runs task on every worker (the caller is
+// worker 0) and returns once all of them are done; dispatch is a pair of
+// barriers, so there is no thread creation per call.
+typedef void (*PoolTask)(void* arg, int worker, int num_workers);
+
+ThreadPool* pool_create(int num_threads, int pin_threads);
+void pool_destroy(ThreadPool* pool);
+void pool_run(ThreadPool* pool, PoolTask task, void* arg);
+int pool_size(ThreadPool* pool);
+int gp_available_cpus(void);
+
 // Function prototypes
+void pop_config_default(PopConfig* cfg);
 Population* pop_create();
+Population* pop_create_config(const PopConfig* cfg);
 void pop_destroy(Population* pop);
 
 Node* node_create(OpType op, int value);
 Node* node_copy(Node* node);
 void node_destroy(Node* node);
+Node* node_intern(Node* node);  // Hash-cons a tree (consumed); returns its shared form
+Node* node_share(Node* node);   // Another reference to a shared tree, else node_copy
 int node_depth(Node* node);
 int node_size(Node* node);
+uint64_t node_hash(Node* node);
+Node* node_inline_library(Node* node, Population* pop);  // Copy without LIB/FUNC_CALL (see gp.c)
+
+NodeArena* node_arena_create(void);
+void node_arena_destroy(NodeArena* arena);
+void node_arena_reset(NodeArena* arena);
+NodeArena* node_arena_use(NodeArena* arena);   // Returns the previously active arena
+void gp_alloc_stats(AllocStats* stats);
+void gp_alloc_stats_reset(void);
 
 Program* prog_create_random(int max_depth, int num_inputs);
 Program* prog_copy(Program* prog);
 void prog_destroy(Program* prog);
 void prog_update_metadata(Program* prog);
+void prog_compile(Program* prog);
+
+// Bytecode compiler (trees are lowered once, then executed without recursion)
+Bytecode* bytecode_compile(Node* root);
+Bytecode* bytecode_copy(const Bytecode* code);
+void bytecode_destroy(Bytecode* code);
+int bytecode_length(const Bytecode* code);
+int bytecode_registers(const Bytecode* code);  // Shared subexpressions cached per run
+int bytecode_set_cse(int enabled);  // Share repeated subtrees in code compiled from now on (default on); returns the old setting
 
 // Visualization
 void print_tree(Node* node, int indent);
@@ -171,15 +482,192 @@ typedef struct {
 } Context;
 
 int execute_node(Node* node, Context* ctx, Population* pop);
+int execute_bytecode(const Bytecode* code, Context* ctx, Population* pop);
 void execute_program(Program* prog, Context* ctx, Population* pop);
 
+// Node executions on the calling thread: VM instructions, interpreted tree
+// nodes, and nodes x cases on the batch and bit-sliced paths. Building with
+// -DGP_NODE_COUNT=0 compiles the counting out of the interpreters; the count
+// (and GenerationStats.nodes_executed) then stays zero.
+#ifndef GP_NODE_COUNT
+#define GP_NODE_COUNT 1
+#endif
+
+uint64_t gp_nodes_executed(void);
+void gp_count_nodes(uint64_t n);
+
+// Bit-sliced execution: every word carries one fitness case per bit, so
+// boolean programs evaluate 64 cases per node. Values are kept as two bit
+// planes (low bit, and the replicated upper bits) which represents 0, 1, -1
+// and -2 exactly, so NOT/EQ/comparisons match execute_program bit for bit.
+#define BITSLICE_LANES 64
+
+typedef struct {
+    uint64_t inputs[MAX_INPUTS];       // Bit j = input value (0/1) of case j
+    int num_inputs;
+    uint64_t lanes;                    // Cases present in this word
+
+    uint64_t outputs[MAX_OUTPUTS];     // Low bit of each output slot
+    uint64_t outputs_high[MAX_OUTPUTS];// Upper bits (set for -1/-2)
+    uint64_t has_output[MAX_OUTPUTS];  // Cases that wrote output slot k
+
+    uint64_t memory[MAX_MEMORY];       // Same two-plane encoding as outputs
+    uint64_t memory_high[MAX_MEMORY];
+} BitContext;
+
+int prog_is_bitsliceable(Program* prog, Population* pop);
+int execute_program_bits(Program* prog, BitContext* ctx, Population* pop);
+void bitslice_truth_table(BitContext* ctx, int num_inputs, int word);
+
+// Batched execution: one program over many cases stored column-major
+// (inputs[i][c] is input i of case c). Each node is evaluated for a block of
+// cases with SSE2/AVX2/AVX-512 kernels picked at runtime.
+typedef struct {
+    int num_cases;
+    int num_inputs;
+    int* inputs[MAX_INPUTS];
+    int* outputs[MAX_OUTPUTS];   // outputs[k][c] is valid for k < num_outputs[c]
+    int* num_outputs;
+    int* memory[MAX_MEMORY];     // Persistent per-case memory
+    int* storage;
+} BatchContext;
+
+BatchContext* batch_create(int num_cases, int num_inputs);
+void batch_destroy(BatchContext* batch);
+void execute_program_batch(Program* prog, BatchContext* batch, Population* pop);
+const char* batch_isa_name(void);
+
+// Island model: independent subpopulations, each evolved on its own pool
+// worker with its own library, random streams and node arenas. Every
+// migration_interval generations an island sends copies of its top
+// num_migrants programs (library calls inlined) to its neighbours through
+// lock-free mailboxes; receivers swap them in for their last programs.
+typedef enum {
+    TOPOLOGY_RING,      // Island i sends to i+1
+    TOPOLOGY_RANDOM,    // Each migration goes to one random other island
+    TOPOLOGY_FULL,      // Every island sends to every other island
+} MigrationTopology;
+
+typedef struct {
+    int num_islands;            // 0 = CPUs available
+    int migration_interval;     // Generations between migrations
+    int num_migrants;           // Programs sent per migration (at most elite_size)
+    MigrationTopology topology;
+    float target_fitness;       // All islands stop once one reaches it
+    int pin_threads;
+    PopConfig pop;              // Settings of each island (num_threads is forced to 1)
+} IslandConfig;
+
+typedef struct {
+    int generation;
+    float best_fitness;
+    uint64_t migrants_sent;
+    uint64_t migrants_received;
+} IslandStats;
+
+typedef struct IslandModel IslandModel;
+
+void island_config_default(IslandConfig* cfg);
+IslandModel* island_create(const IslandConfig* cfg);
+void island_destroy(IslandModel* model);
+void island_evolve(IslandModel* model, FitnessFn fitness_fn, void* data, int num_inputs, int generations);
+int island_count(IslandModel* model);
+Population* island_population(IslandModel* model, int island);
+int island_best_index(IslandModel* model);
+void island_stats(IslandModel* model, int island, IslandStats* stats);
+
+// Linear genome (gp_linear.c): a tree as one prefix-order array of 12-byte
+// entries. Every entry records the extent and depth of its subtree, so
+// subtrees are contiguous ranges, size and depth are stored rather than
+// recomputed, and crossover splices ranges. Missing children (NULL in the
+// tree) take a LINEAR_NONE entry, so conversion round-trips exactly. Library
+// bodies stay pointer trees; linear_to_tree gives the tree form for
+// print_tree and the rest of the tree API.
+#define LINEAR_NONE 0xff
+
+typedef struct {
+    uint8_t op;             // OpType, or LINEAR_NONE for a missing child
+    uint8_t num_children;
+    uint16_t depth;         // node_depth of the subtree rooted here
+    int value;
+    int extent;             // Entries in the subtree rooted here, itself included
+} LinearNode;
+
+typedef struct {
+    LinearNode* nodes;      // nodes[0] is the root
+    int length;             // Entries, LINEAR_NONE ones included
+    int size;               // node_size of the tree
+    int depth;              // node_depth of the tree
+} LinearTree;
+
+LinearTree* linear_from_tree(Node* root);
+Node* linear_to_tree(const LinearTree* lt);
+LinearTree* linear_copy(const LinearTree* lt);
+void linear_destroy(LinearTree* lt);
+int execute_linear(const LinearTree* lt, Context* ctx, Population* pop);  // Same semantics as execute_node
+LinearTree* linear_splice(const LinearTree* dst, int at, const LinearTree* src, int from);  // dst with subtree at replaced by src's subtree at from
+LinearTree* linear_crossover(const LinearTree* p1, const LinearTree* p2);  // Same draws and result as evolve_crossover
+
+// Program serialization (compact pre-order encoding, see gp_net.c).
+// prog_serialize returns the encoded size and writes only if it fits in cap;
+// library calls are written as-is, so inline them first when the reader
+// has a different library. Missing children are encoded and come back as
+// NULL. prog_deserialize returns NULL on malformed input.
+size_t prog_serialize(const Program* prog, uint8_t* buf, size_t cap);
+Program* prog_deserialize(const uint8_t* buf, size_t len, size_t* used);
+
+// Multi-process islands: each process connects to a coordinator (address
+// "unix:/path" or "tcp:host:port"), which relays migrants between them
+// along the topology. The coordinator can run in any process, including
+// one that forks the islands on localhost.
+typedef struct {
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t frames_sent;
+    uint64_t frames_received;
+    uint64_t migrants_sent;
+    uint64_t migrants_received;
+    double latency_total;       // Sum over received frames of pickup time - send time (seconds)
+    double latency_max;
+    uint64_t frames_dropped;    // Coordinator: frames not relayed because the island fell behind
+} MigrationLinkStats;
+
+typedef struct MigrationClient MigrationClient;
+
+// Accepts num_islands connections and relays until all have disconnected.
+// link_stats (num_islands entries, may be NULL) receives the coordinator's
+// view of each link. Returns 0, or -1 if the islands never all connected.
+int migration_coordinator_run(const char* address, int num_islands, MigrationTopology topology,
+                              MigrationLinkStats* link_stats);
+
+MigrationClient* migration_connect(const char* address);  // Waits for all islands; NULL on failure
+void migration_close(MigrationClient* client);
+int migration_island_id(MigrationClient* client);
+int migration_num_islands(MigrationClient* client);
+int migration_send(MigrationClient* client, Program** progs, int count, Population* pop);  // pop != NULL inlines its library
+int migration_receive(MigrationClient* client, Program** out, int max);  // Never blocks; -1 once the coordinator is gone
+int migration_exchange(MigrationClient* client, Population* pop, int num_migrants);
+void migration_stats(MigrationClient* client, MigrationLinkStats* stats);
+
 // Evolution operators
 Program* evolve_mutate(Program* parent, Population* pop);
 Program* evolve_crossover(Program* p1, Program* p2);
-void evolve_simplify(Program* prog);
+void evolve_simplify(Program* prog);     // Semantics-preserving rewrite of the genotype
+int simplify_mode_parse(const char* name);  // "off", "eval", "genotype"; -1 if unknown
+int prog_prune_dead(Program* prog, const ValueRange* inputs, int num_inputs);  // Returns nodes removed
+Program* tournament_select(Population* pop);  // Best of tournament_size uniform picks
 
 // Evolution
-void evolve_generation(Population* pop, float (*fitness_fn)(Program*, void*), void* data, int num_inputs);
+void evolve_generation(Population* pop, FitnessFn fitness_fn, void* data, int num_inputs);
+void pop_rank(Population* pop);
+int pop_stats_json(Population* pop, char* buf, size_t cap);  // pop->stats as one JSON object (snprintf semantics)
+
+// Steady-state evolution: workers keep selecting parents by tournament,
+// breeding one child, scoring it and replacing the loser of an inverse
+// tournament, with no generation barrier. Every pop_size offspring count as
+// a generation. Which slots get replaced depends on thread timing, so runs
+// are only reproducible with one thread. Fills pop->stats for the call.
+void evolve_steady_state(Population* pop, FitnessFn fitness_fn, void* data, int num_inputs, int offspring);
 
 // Library learning
 void library_add(Population* pop, Node* pattern, const char* name, float fitness);
@@ -0,0 +1,953 @@
+#include "gp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Bit-sliced evaluation
+//
+// A value is a pair of planes (hi, lo): lo holds bit 0 of every case and hi
+// holds bits 1..31, which are all equal for the values a boolean program can
+// produce from 0/1 inputs (0, 1, -1 = ~0 and -2 = ~1). Bitwise ops act on both
+// planes, comparisons order the encodings as -2 < -1 < 0 < 1, and anything that
+// leaves that set (ADD, NEG, SIN, other constants...) is rejected up front.
+
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} BitValue;
+
+typedef struct {
+    BitContext* ctx;
+    Population* pop;
+    BitValue args[MAX_CHILDREN * 4];   // Mirrors Context.args
+    int arg_stack_ptr;
+    int arg_frame_base;
+    int ok;                            // Cleared if an unsupported node is reached
+} BitState;
+
+static const BitValue BIT_ZERO = {0, 0};
+
+static int bit_const_ok(int value) {
+    return value >= -2 && value <= 1;
+}
+
+static BitValue bit_const(int value) {
+    BitValue v;
+    v.hi = (value < 0) ? ~0ULL : 0;
+    v.lo = (value & 1) ? ~0ULL : 0;
+    return v;
+}
+
+static BitValue bit_flag(uint64_t bits) {
+    BitValue v = {0, bits};
+    return v;
+}
+
+static BitValue bit_blend(uint64_t sel, BitValue a, BitValue b) {
+    BitValue v;
+    v.hi = (sel & a.hi) | (~sel & b.hi);
+    v.lo = (sel & a.lo) | (~sel & b.lo);
+    return v;
+}
+
+// Lanes where a > b (signed)
+static uint64_t bit_gt(BitValue a, BitValue b) {
+    uint64_t sa = ~a.hi;
+    uint64_t sb = ~b.hi;
+    return (sa & ~sb) | (~(sa ^ sb) & a.lo & ~b.lo);
+}
+
+static uint64_t bit_eq(BitValue a, BitValue b) {
+    return ~(a.hi ^ b.hi) & ~(a.lo ^ b.lo);
+}
+
+static uint64_t bit_nonzero(BitValue a) {
+    return a.hi | a.lo;
+}
+
+static int bit_node_supported(Node* node, Population* pop, int call_depth) {
+    if (!node) return 1;
+
+    switch (node->op) {
+        case OP_AND: case OP_OR: case OP_XOR: case OP_NOT:
+        case OP_EQ: case OP_LT: case OP_LTE: case OP_GT:
+        case OP_MAX: case OP_MIN: case OP_STEP: case OP_IDENT:
+        case OP_IF: case OP_IF_GT: case OP_SEQ:
+        case OP_OUTPUT: case OP_MEM_WRITE:
+            break;
+        case OP_INPUT: case OP_MEM_READ: case OP_PARAM:
+            return 1;
+        case OP_CONST:
+            return bit_const_ok(node->value);
+        case OP_LIBRARY:
+        case OP_FUNC_CALL: {
+            // Without a library these evaluate to 0 and skip their children
+            int idx = node->value;
+            if (!pop || idx < 0 || idx >= pop->library_size) return 1;
+            if (call_depth >= MAX_CALL_DEPTH) return 1;
+            if (!bit_node_supported(pop->library[idx].tree, pop, call_depth + 1)) return 0;
+            break;
+        }
+        default:
+            return 0;
+    }
+
+    int arity = (node->op == OP_FUNC_CALL) ? node->num_children : op_info[node->op].arity;
+    for (int i = 0; i < arity; i++) {
+        if (!bit_node_supported(node->children[i], pop, call_depth)) return 0;
+    }
+    return 1;
+}
+
+int prog_is_bitsliceable(Program* prog, Population* pop) {
+    if (!prog || !prog->root) return 0;
+    return bit_node_supported(prog->root, pop, 0);
+}
+
+static BitValue bit_eval(Node* node, uint64_t mask, BitState* st, int call_depth);
+
+static BitValue bit_call_library(int idx, uint64_t mask, BitState* st, int call_depth) {
+    if (call_depth >= MAX_CALL_DEPTH) return BIT_ZERO;
+    return bit_eval(st->pop->library[idx].tree, mask, st, call_depth + 1);
+}
+
+static BitValue bit_eval(Node* node, uint64_t mask, BitState* st, int call_depth) {
+    if (!node) return BIT_ZERO;
+    BitContext* ctx = st->ctx;
+#ifdef GP_PROFILE
+    gp_profile_count(node->op, __builtin_popcountll(mask));
+#endif
+
+    switch (node->op) {
+        case OP_AND: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            BitValue v = {a.hi & b.hi, a.lo & b.lo};
+            return v;
+        }
+        case OP_OR: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            BitValue v = {a.hi | b.hi, a.lo | b.lo};
+            return v;
+        }
+        case OP_XOR: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            BitValue v = {a.hi ^ b.hi, a.lo ^ b.lo};
+            return v;
+        }
+        case OP_NOT: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue v = {~a.hi, ~a.lo};
+            return v;
+        }
+        case OP_EQ: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_flag(bit_eq(a, b));
+        }
+        case OP_LT: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_flag(bit_gt(b, a));
+        }
+        case OP_LTE: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_flag(~bit_gt(a, b));
+        }
+        case OP_GT: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_flag(bit_gt(a, b));
+        }
+        case OP_MAX: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_blend(bit_gt(a, b), a, b);
+        }
+        case OP_MIN: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            return bit_blend(bit_gt(b, a), a, b);
+        }
+        case OP_STEP: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            return bit_flag(~a.hi & a.lo);
+        }
+        case OP_IDENT:
+            return bit_eval(node->children[0], mask, st, call_depth);
+        case OP_CONST:
+            if (!bit_const_ok(node->value)) {
+                st->ok = 0;
+                return BIT_ZERO;
+            }
+            return bit_const(node->value);
+        case OP_INPUT: {
+            int idx = node->value;
+            if (idx >= 0 && idx < ctx->num_inputs && idx < MAX_INPUTS) {
+                return bit_flag(ctx->inputs[idx]);
+            }
+            return BIT_ZERO;
+        }
+        case OP_OUTPUT: {
+            BitValue val = bit_eval(node->children[0], mask, st, call_depth);
+            // has_output is a thermometer code of each case's output count;
+            // a case writes slot k when it has produced exactly k outputs
+            uint64_t prev = mask;
+            for (int k = 0; k < MAX_OUTPUTS; k++) {
+                uint64_t write = prev & ~ctx->has_output[k];
+                ctx->outputs[k] = (write & val.lo) | (~write & ctx->outputs[k]);
+                ctx->outputs_high[k] = (write & val.hi) | (~write & ctx->outputs_high[k]);
+                ctx->has_output[k] |= write;
+                prev &= ~write;
+                if (!prev) break;
+            }
+            return BIT_ZERO;
+        }
+        case OP_IF_GT: {
+            BitValue a = bit_eval(node->children[0], mask, st, call_depth);
+            BitValue b = bit_eval(node->children[1], mask, st, call_depth);
+            uint64_t taken = bit_gt(a, b);
+            BitValue c = (mask & taken) ? bit_eval(node->children[2], mask & taken, st, call_depth) : BIT_ZERO;
+            BitValue d = (mask & ~taken) ? bit_eval(node->children[3], mask & ~taken, st, call_depth) : BIT_ZERO;
+            return bit_blend(taken, c, d);
+        }
+        case OP_IF: {
+            BitValue cond = bit_eval(node->children[0], mask, st, call_depth);
+            uint64_t taken = bit_nonzero(cond);
+            BitValue a = (mask & taken) ? bit_eval(node->children[1], mask & taken, st, call_depth) : BIT_ZERO;
+            BitValue b = (mask & ~taken) ? bit_eval(node->children[2], mask & ~taken, st, call_depth) : BIT_ZERO;
+            return bit_blend(taken, a, b);
+        }
+        case OP_SEQ:
+            bit_eval(node->children[0], mask, st, call_depth);
+            bit_eval(node->children[1], mask, st, call_depth);
+            return BIT_ZERO;
+        case OP_LIBRARY: {
+            int idx = node->value;
+            if (st->pop && idx >= 0 && idx < st->pop->library_size) {
+                return bit_call_library(idx, mask, st, call_depth);
+            }
+            return BIT_ZERO;
+        }
+        case OP_MEM_READ: {
+            int idx = node->value;
+            if (idx >= 0 && idx < MAX_MEMORY) {
+                BitValue v = {ctx->memory_high[idx], ctx->memory[idx]};
+                return v;
+            }
+            return BIT_ZERO;
+        }
+        case OP_MEM_WRITE: {
+            int idx = node->value;
+            BitValue val = bit_eval(node->children[0], mask, st, call_depth);
+            if (idx >= 0 && idx < MAX_MEMORY) {
+                ctx->memory[idx] = (mask & val.lo) | (~mask & ctx->memory[idx]);
+                ctx->memory_high[idx] = (mask & val.hi) | (~mask & ctx->memory_high[idx]);
+            }
+            return BIT_ZERO;
+        }
+        case OP_FUNC_CALL: {
+            int func_idx = node->value;
+            Population* pop = st->pop;
+            if (pop && func_idx >= 0 && func_idx < pop->library_size) {
+                LibraryEntry* func = &pop->library[func_idx];
+                int capacity = (int)(sizeof(st->args) / sizeof(st->args[0]));
+
+                int old_stack_ptr = st->arg_stack_ptr;
+                int old_frame_base = st->arg_frame_base;
+
+                for (int i = 0; i < func->num_params && i < node->num_children; i++) {
+                    BitValue v = bit_eval(node->children[i], mask, st, call_depth);
+                    if (st->arg_stack_ptr < capacity) st->args[st->arg_stack_ptr] = v;
+                    st->arg_stack_ptr++;
+                }
+
+                st->arg_frame_base = old_stack_ptr;
+                BitValue result = bit_call_library(func_idx, mask, st, call_depth);
+
+                st->arg_stack_ptr = old_stack_ptr;
+                st->arg_frame_base = old_frame_base;
+                return result;
+            }
+            return BIT_ZERO;
+        }
+        case OP_PARAM: {
+            int capacity = (int)(sizeof(st->args) / sizeof(st->args[0]));
+            int arg_pos = st->arg_frame_base + node->value;
+            if (arg_pos >= 0 && arg_pos < st->arg_stack_ptr && arg_pos < capacity) {
+                return st->args[arg_pos];
+            }
+            return BIT_ZERO;
+        }
+        default:
+            st->ok = 0;
+            return BIT_ZERO;
+    }
+}
+
+// Evaluate a boolean program on up to 64 cases at once. Outputs are reset
+// (memory is kept, like execute_program). Returns 0 if the program uses an op
+// outside the boolean subset; callers should check prog_is_bitsliceable first
+// and use the scalar path for those programs.
+int execute_program_bits(Program* prog, BitContext* ctx, Population* pop) {
+    memset(ctx->outputs, 0, sizeof(ctx->outputs));
+    memset(ctx->outputs_high, 0, sizeof(ctx->outputs_high));
+    memset(ctx->has_output, 0, sizeof(ctx->has_output));
+    if (!prog || !prog->root) return 1;
+
+    BitState st = {0};
+    st.ctx = ctx;
+    st.pop = pop;
+    st.ok = 1;
+    bit_eval(prog->root, ctx->lanes, &st, 0);
+    gp_count_nodes((uint64_t)prog->size * __builtin_popcountll(ctx->lanes));
+    return st.ok;
+}
+
+// Fill inputs for exhaustive enumeration of an n-input truth table, where
+// lane j of word w is case w * 64 + j and input i is bit i of the case.
+void bitslice_truth_table(BitContext* ctx, int num_inputs, int word) {
+    static const uint64_t lane_bits[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+    };
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->num_inputs = num_inputs;
+    for (int i = 0; i < num_inputs && i < MAX_INPUTS; i++) {
+        if (i < 6) {
+            ctx->inputs[i] = lane_bits[i];
+        } else {
+            ctx->inputs[i] = ((word >> (i - 6)) & 1) ? ~0ULL : 0;
+        }
+    }
+
+    int total_bits = num_inputs < 6 ? num_inputs : 6;
+    ctx->lanes = (total_bits == 6) ? ~0ULL : ((1ULL << (1 << total_bits)) - 1);
+}
+
+// SIMD batched evaluation
+//
+// execute_program_batch walks the tree once per block of BATCH_BLOCK cases,
+// computing each node over every lane with the widest integer kernels the CPU
+// supports. IF/IF_GT evaluate each branch under a lane mask (skipping branches
+// no lane takes) and blend the results; OUTPUT and MEM_WRITE only touch the
+// lanes in the mask, so side effects match execute_program case by case.
+
+#define BATCH_BLOCK 64
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BATCH_X86 1
+#endif
+
+// Vector kernel operations (results of comparisons are 0/1 unless noted)
+enum {
+    K_ADD, K_SUB, K_MUL, K_AND, K_OR, K_XOR,
+    K_ANDNOT,        // a & ~b
+    K_EQ, K_LT, K_LTE, K_GT,
+    K_GT_MASK,       // a > b as -1/0
+    K_MAX, K_MIN,
+};
+
+enum {
+    K_NOT, K_NEG, K_ABS, K_STEP,
+    K_NONZERO,       // a != 0 as -1/0
+};
+
+typedef struct {
+    const char* name;
+    void (*binary)(int op, int32_t* dst, const int32_t* a, const int32_t* b);
+    void (*unary)(int op, int32_t* dst, const int32_t* a);
+    void (*blend)(int32_t* dst, const int32_t* sel, const int32_t* a, const int32_t* b);
+} BatchKernels;
+
+// Scalar kernels (portable fallback)
+
+#define SCALAR_BINARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i++) { int32_t x = a[i], y = b[i]; dst[i] = (expr); } break;
+#define SCALAR_UNARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i++) { int32_t x = a[i]; dst[i] = (expr); } break;
+
+static void scalar_binary(int op, int32_t* dst, const int32_t* a, const int32_t* b) {
+    switch (op) {
+        case K_ADD: SCALAR_BINARY((int32_t)((uint32_t)x + (uint32_t)y))
+        case K_SUB: SCALAR_BINARY((int32_t)((uint32_t)x - (uint32_t)y))
+        case K_MUL: SCALAR_BINARY((int32_t)((uint32_t)x * (uint32_t)y))
+        case K_AND: SCALAR_BINARY(x & y)
+        case K_OR: SCALAR_BINARY(x | y)
+        case K_XOR: SCALAR_BINARY(x ^ y)
+        case K_ANDNOT: SCALAR_BINARY(x & ~y)
+        case K_EQ: SCALAR_BINARY(x == y)
+        case K_LT: SCALAR_BINARY(x < y)
+        case K_LTE: SCALAR_BINARY(x <= y)
+        case K_GT: SCALAR_BINARY(x > y)
+        case K_GT_MASK: SCALAR_BINARY(-(x > y))
+        case K_MAX: SCALAR_BINARY((x > y) ? x : y)
+        case K_MIN: SCALAR_BINARY((x < y) ? x : y)
+    }
+}
+
+static void scalar_unary(int op, int32_t* dst, const int32_t* a) {
+    switch (op) {
+        case K_NOT: SCALAR_UNARY(~x)
+        case K_NEG: SCALAR_UNARY((int32_t)(0u - (uint32_t)x))
+        case K_ABS: SCALAR_UNARY((x < 0) ? (int32_t)(0u - (uint32_t)x) : x)
+        case K_STEP: SCALAR_UNARY(x > 0)
+        case K_NONZERO: SCALAR_UNARY(-(x != 0))
+    }
+}
+
+static void scalar_blend(int32_t* dst, const int32_t* sel, const int32_t* a, const int32_t* b) {
+    for (int i = 0; i < BATCH_BLOCK; i++) {
+        dst[i] = sel[i] ? a[i] : b[i];
+    }
+}
+
+static const BatchKernels scalar_kernels = {"scalar", scalar_binary, scalar_unary, scalar_blend};
+
+#ifdef BATCH_X86
+
+// SSE2 kernels (baseline on x86-64; MUL/MAX/MIN/ABS are emulated)
+
+#define SSE2_BINARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 4) { \
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i)); \
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i)); \
+        _mm_storeu_si128((__m128i*)(dst + i), (expr)); \
+    } break;
+#define SSE2_UNARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 4) { \
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i)); \
+        _mm_storeu_si128((__m128i*)(dst + i), (expr)); \
+    } break;
+
+static inline __m128i sse2_mullo(__m128i x, __m128i y) {
+    __m128i even = _mm_mul_epu32(x, y);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i sse2_select(__m128i m, __m128i x, __m128i y) {
+    return _mm_or_si128(_mm_and_si128(m, x), _mm_andnot_si128(m, y));
+}
+
+static void sse2_binary(int op, int32_t* dst, const int32_t* a, const int32_t* b) {
+    const __m128i one = _mm_set1_epi32(1);
+    switch (op) {
+        case K_ADD: SSE2_BINARY(_mm_add_epi32(x, y))
+        case K_SUB: SSE2_BINARY(_mm_sub_epi32(x, y))
+        case K_MUL: SSE2_BINARY(sse2_mullo(x, y))
+        case K_AND: SSE2_BINARY(_mm_and_si128(x, y))
+        case K_OR: SSE2_BINARY(_mm_or_si128(x, y))
+        case K_XOR: SSE2_BINARY(_mm_xor_si128(x, y))
+        case K_ANDNOT: SSE2_BINARY(_mm_andnot_si128(y, x))
+        case K_EQ: SSE2_BINARY(_mm_and_si128(_mm_cmpeq_epi32(x, y), one))
+        case K_LT: SSE2_BINARY(_mm_and_si128(_mm_cmplt_epi32(x, y), one))
+        case K_LTE: SSE2_BINARY(_mm_andnot_si128(_mm_cmpgt_epi32(x, y), one))
+        case K_GT: SSE2_BINARY(_mm_and_si128(_mm_cmpgt_epi32(x, y), one))
+        case K_GT_MASK: SSE2_BINARY(_mm_cmpgt_epi32(x, y))
+        case K_MAX: SSE2_BINARY(sse2_select(_mm_cmpgt_epi32(x, y), x, y))
+        case K_MIN: SSE2_BINARY(sse2_select(_mm_cmplt_epi32(x, y), x, y))
+    }
+}
+
+static void sse2_unary(int op, int32_t* dst, const int32_t* a) {
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    switch (op) {
+        case K_NOT: SSE2_UNARY(_mm_xor_si128(x, ones))
+        case K_NEG: SSE2_UNARY(_mm_sub_epi32(zero, x))
+        case K_ABS: SSE2_UNARY(_mm_sub_epi32(_mm_xor_si128(x, _mm_srai_epi32(x, 31)), _mm_srai_epi32(x, 31)))
+        case K_STEP: SSE2_UNARY(_mm_and_si128(_mm_cmpgt_epi32(x, zero), one))
+        case K_NONZERO: SSE2_UNARY(_mm_xor_si128(_mm_cmpeq_epi32(x, zero), ones))
+    }
+}
+
+static void sse2_blend(int32_t* dst, const int32_t* sel, const int32_t* a, const int32_t* b) {
+    for (int i = 0; i < BATCH_BLOCK; i += 4) {
+        __m128i m = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(sel + i)), _mm_setzero_si128());
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(dst + i), sse2_select(m, y, x));
+    }
+}
+
+static const BatchKernels sse2_kernels = {"sse2", sse2_binary, sse2_unary, sse2_blend};
+
+// AVX2 kernels
+
+#define AVX2_BINARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 8) { \
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i)); \
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i)); \
+        _mm256_storeu_si256((__m256i*)(dst + i), (expr)); \
+    } break;
+#define AVX2_UNARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 8) { \
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i)); \
+        _mm256_storeu_si256((__m256i*)(dst + i), (expr)); \
+    } break;
+
+__attribute__((target("avx2")))
+static void avx2_binary(int op, int32_t* dst, const int32_t* a, const int32_t* b) {
+    const __m256i one = _mm256_set1_epi32(1);
+    switch (op) {
+        case K_ADD: AVX2_BINARY(_mm256_add_epi32(x, y))
+        case K_SUB: AVX2_BINARY(_mm256_sub_epi32(x, y))
+        case K_MUL: AVX2_BINARY(_mm256_mullo_epi32(x, y))
+        case K_AND: AVX2_BINARY(_mm256_and_si256(x, y))
+        case K_OR: AVX2_BINARY(_mm256_or_si256(x, y))
+        case K_XOR: AVX2_BINARY(_mm256_xor_si256(x, y))
+        case K_ANDNOT: AVX2_BINARY(_mm256_andnot_si256(y, x))
+        case K_EQ: AVX2_BINARY(_mm256_and_si256(_mm256_cmpeq_epi32(x, y), one))
+        case K_LT: AVX2_BINARY(_mm256_and_si256(_mm256_cmpgt_epi32(y, x), one))
+        case K_LTE: AVX2_BINARY(_mm256_andnot_si256(_mm256_cmpgt_epi32(x, y), one))
+        case K_GT: AVX2_BINARY(_mm256_and_si256(_mm256_cmpgt_epi32(x, y), one))
+        case K_GT_MASK: AVX2_BINARY(_mm256_cmpgt_epi32(x, y))
+        case K_MAX: AVX2_BINARY(_mm256_max_epi32(x, y))
+        case K_MIN: AVX2_BINARY(_mm256_min_epi32(x, y))
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_unary(int op, int32_t* dst, const int32_t* a) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    switch (op) {
+        case K_NOT: AVX2_UNARY(_mm256_xor_si256(x, ones))
+        case K_NEG: AVX2_UNARY(_mm256_sub_epi32(zero, x))
+        case K_ABS: AVX2_UNARY(_mm256_abs_epi32(x))
+        case K_STEP: AVX2_UNARY(_mm256_and_si256(_mm256_cmpgt_epi32(x, zero), one))
+        case K_NONZERO: AVX2_UNARY(_mm256_xor_si256(_mm256_cmpeq_epi32(x, zero), ones))
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_blend(int32_t* dst, const int32_t* sel, const int32_t* a, const int32_t* b) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < BATCH_BLOCK; i += 8) {
+        __m256i m = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(sel + i)), zero);
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(x, y, m));
+    }
+}
+
+static const BatchKernels avx2_kernels = {"avx2", avx2_binary, avx2_unary, avx2_blend};
+
+// AVX-512 kernels
+
+#define AVX512_BINARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 16) { \
+        __m512i x = _mm512_loadu_si512((const void*)(a + i)); \
+        __m512i y = _mm512_loadu_si512((const void*)(b + i)); \
+        _mm512_storeu_si512((void*)(dst + i), (expr)); \
+    } break;
+#define AVX512_UNARY(expr) \
+    for (int i = 0; i < BATCH_BLOCK; i += 16) { \
+        __m512i x = _mm512_loadu_si512((const void*)(a + i)); \
+        _mm512_storeu_si512((void*)(dst + i), (expr)); \
+    } break;
+
+__attribute__((target("avx512f")))
+static void avx512_binary(int op, int32_t* dst, const int32_t* a, const int32_t* b) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i ones = _mm512_set1_epi32(-1);
+    switch (op) {
+        case K_ADD: AVX512_BINARY(_mm512_add_epi32(x, y))
+        case K_SUB: AVX512_BINARY(_mm512_sub_epi32(x, y))
+        case K_MUL: AVX512_BINARY(_mm512_mullo_epi32(x, y))
+        case K_AND: AVX512_BINARY(_mm512_and_si512(x, y))
+        case K_OR: AVX512_BINARY(_mm512_or_si512(x, y))
+        case K_XOR: AVX512_BINARY(_mm512_xor_si512(x, y))
+        case K_ANDNOT: AVX512_BINARY(_mm512_andnot_si512(y, x))
+        case K_EQ: AVX512_BINARY(_mm512_maskz_mov_epi32(_mm512_cmpeq_epi32_mask(x, y), one))
+        case K_LT: AVX512_BINARY(_mm512_maskz_mov_epi32(_mm512_cmplt_epi32_mask(x, y), one))
+        case K_LTE: AVX512_BINARY(_mm512_maskz_mov_epi32(_mm512_cmple_epi32_mask(x, y), one))
+        case K_GT: AVX512_BINARY(_mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(x, y), one))
+        case K_GT_MASK: AVX512_BINARY(_mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(x, y), ones))
+        case K_MAX: AVX512_BINARY(_mm512_max_epi32(x, y))
+        case K_MIN: AVX512_BINARY(_mm512_min_epi32(x, y))
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_unary(int op, int32_t* dst, const int32_t* a) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi32(-1);
+    switch (op) {
+        case K_NOT: AVX512_UNARY(_mm512_xor_si512(x, ones))
+        case K_NEG: AVX512_UNARY(_mm512_sub_epi32(zero, x))
+        case K_ABS: AVX512_UNARY(_mm512_abs_epi32(x))
+        case K_STEP: AVX512_UNARY(_mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(x, zero), one))
+        case K_NONZERO: AVX512_UNARY(_mm512_maskz_mov_epi32(_mm512_test_epi32_mask(x, x), ones))
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_blend(int32_t* dst, const int32_t* sel, const int32_t* a, const int32_t* b) {
+    for (int i = 0; i < BATCH_BLOCK; i += 16) {
+        __m512i s = _mm512_loadu_si512((const void*)(sel + i));
+        __m512i x = _mm512_loadu_si512((const void*)(a + i));
+        __m512i y = _mm512_loadu_si512((const void*)(b + i));
+        _mm512_storeu_si512((void*)(dst + i), _mm512_mask_blend_epi32(_mm512_test_epi32_mask(s, s), y, x));
+    }
+}
+
+static const BatchKernels avx512_kernels = {"avx512", avx512_binary, avx512_unary, avx512_blend};
+
+#endif  // BATCH_X86
+
+// Runtime dispatch: widest ISA the CPU supports, overridable with
+// GP_BATCH_ISA=scalar|sse2|avx2|avx512 for testing
+static const BatchKernels* batch_kernels = &scalar_kernels;
+static pthread_once_t batch_kernels_once = PTHREAD_ONCE_INIT;
+
+static void batch_select_kernels(void) {
+    const BatchKernels* best = &scalar_kernels;
+    const BatchKernels* forced = NULL;
+    const char* force = getenv("GP_BATCH_ISA");
+
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+    best = &sse2_kernels;
+    if (__builtin_cpu_supports("avx2")) best = &avx2_kernels;
+    if (__builtin_cpu_supports("avx512f")) best = &avx512_kernels;
+
+    if (force) {
+        if (strcmp(force, "sse2") == 0) forced = &sse2_kernels;
+        if (strcmp(force, "avx2") == 0 && __builtin_cpu_supports("avx2")) forced = &avx2_kernels;
+        if (strcmp(force, "avx512") == 0 && __builtin_cpu_supports("avx512f")) forced = &avx512_kernels;
+    }
+#endif
+    if (force && strcmp(force, "scalar") == 0) forced = &scalar_kernels;
+
+    batch_kernels = forced ? forced : best;
+}
+
+const char* batch_isa_name(void) {
+    pthread_once(&batch_kernels_once, batch_select_kernels);
+    return batch_kernels->name;
+}
+
+// Batch contexts
+
+BatchContext* batch_create(int num_cases, int num_inputs) {
+    BatchContext* batch = calloc(1, sizeof(BatchContext));
+    int columns = MAX_INPUTS + MAX_OUTPUTS + MAX_MEMORY + 1;
+    batch->storage = calloc((size_t)columns * num_cases, sizeof(int));
+    batch->num_cases = num_cases;
+    batch->num_inputs = num_inputs;
+
+    int* col = batch->storage;
+    for (int i = 0; i < MAX_INPUTS; i++, col += num_cases) batch->inputs[i] = col;
+    for (int i = 0; i < MAX_OUTPUTS; i++, col += num_cases) batch->outputs[i] = col;
+    for (int i = 0; i < MAX_MEMORY; i++, col += num_cases) batch->memory[i] = col;
+    batch->num_outputs = col;
+    return batch;
+}
+
+void batch_destroy(BatchContext* batch) {
+    if (!batch) return;
+    free(batch->storage);
+    free(batch);
+}
+
+// Per-block evaluation state
+typedef struct {
+    const BatchKernels* k;
+    Population* pop;
+    int num_inputs;
+    int32_t inputs[MAX_INPUTS][BATCH_BLOCK];
+    int32_t memory[MAX_MEMORY][BATCH_BLOCK];
+    int32_t outputs[MAX_OUTPUTS][BATCH_BLOCK];
+    int32_t num_outputs[BATCH_BLOCK];
+    int32_t args[MAX_CHILDREN * 4][BATCH_BLOCK];   // Mirrors Context.args
+    int arg_stack_ptr;
+    int arg_frame_base;
+} BatchState;
+
+#define BATCH_ARGS_CAPACITY (MAX_CHILDREN * 4)
+
+static int batch_any(const int32_t* mask) {
+    int32_t any = 0;
+    for (int i = 0; i < BATCH_BLOCK; i++) any |= mask[i];
+    return any != 0;
+}
+
+static void batch_fill(int32_t* dst, int32_t value) {
+    for (int i = 0; i < BATCH_BLOCK; i++) dst[i] = value;
+}
+
+static void batch_eval(Node* node, const int32_t* mask, BatchState* st, int call_depth, int32_t* out);
+
+static void batch_eval_binary(Node* node, int op, const int32_t* mask, BatchState* st, int call_depth, int32_t* out) {
+    int32_t b[BATCH_BLOCK];
+    batch_eval(node->children[0], mask, st, call_depth, out);
+    batch_eval(node->children[1], mask, st, call_depth, b);
+    st->k->binary(op, out, out, b);
+}
+
+static void batch_eval_unary(Node* node, int op, const int32_t* mask, BatchState* st, int call_depth, int32_t* out) {
+    batch_eval(node->children[0], mask, st, call_depth, out);
+    st->k->unary(op, out, out);
+}
+
+// Evaluate both arms of a conditional under their masks and blend
+static void batch_eval_branches(Node* then_node, Node* else_node, const int32_t* taken,
+                                const int32_t* mask, BatchState* st, int call_depth, int32_t* out) {
+    int32_t then_mask[BATCH_BLOCK];
+    int32_t else_mask[BATCH_BLOCK];
+    int32_t then_val[BATCH_BLOCK];
+
+    st->k->binary(K_AND, then_mask, mask, taken);
+    st->k->binary(K_ANDNOT, else_mask, mask, taken);
+
+    if (batch_any(then_mask)) {
+        batch_eval(then_node, then_mask, st, call_depth, then_val);
+    } else {
+        batch_fill(then_val, 0);
+    }
+    if (batch_any(else_mask)) {
+        batch_eval(else_node, else_mask, st, call_depth, out);
+    } else {
+        batch_fill(out, 0);
+    }
+    st->k->blend(out, taken, then_val, out);
+}
+
+static void batch_call_library(int idx, const int32_t* mask, BatchState* st, int call_depth, int32_t* out) {
+    if (call_depth >= MAX_CALL_DEPTH) {
+        batch_fill(out, 0);
+        return;
+    }
+    batch_eval(st->pop->library[idx].tree, mask, st, call_depth + 1, out);
+}
+
+static void batch_eval(Node* node, const int32_t* mask, BatchState* st, int call_depth, int32_t* out) {
+    if (!node) {
+        batch_fill(out, 0);
+        return;
+    }
+#ifdef GP_PROFILE
+    int lanes = 0;
+    for (int i = 0; i < BATCH_BLOCK; i++) lanes += mask[i] != 0;
+    gp_profile_count(node->op, lanes);
+#endif
+
+    switch (node->op) {
+        case OP_ADD: batch_eval_binary(node, K_ADD, mask, st, call_depth, out); break;
+        case OP_SUB: batch_eval_binary(node, K_SUB, mask, st, call_depth, out); break;
+        case OP_MUL: batch_eval_binary(node, K_MUL, mask, st, call_depth, out); break;
+        case OP_AND: batch_eval_binary(node, K_AND, mask, st, call_depth, out); break;
+        case OP_OR: batch_eval_binary(node, K_OR, mask, st, call_depth, out); break;
+        case OP_XOR: batch_eval_binary(node, K_XOR, mask, st, call_depth, out); break;
+        case OP_EQ: batch_eval_binary(node, K_EQ, mask, st, call_depth, out); break;
+        case OP_LT: batch_eval_binary(node, K_LT, mask, st, call_depth, out); break;
+        case OP_LTE: batch_eval_binary(node, K_LTE, mask, st, call_depth, out); break;
+        case OP_GT: batch_eval_binary(node, K_GT, mask, st, call_depth, out); break;
+        case OP_MAX: batch_eval_binary(node, K_MAX, mask, st, call_depth, out); break;
+        case OP_MIN: batch_eval_binary(node, K_MIN, mask, st, call_depth, out); break;
+        case OP_NOT: batch_eval_unary(node, K_NOT, mask, st, call_depth, out); break;
+        case OP_ABS: batch_eval_unary(node, K_ABS, mask, st, call_depth, out); break;
+        case OP_NEG: batch_eval_unary(node, K_NEG, mask, st, call_depth, out); break;
+        case OP_STEP: batch_eval_unary(node, K_STEP, mask, st, call_depth, out); break;
+        case OP_DIV:
+        case OP_MOD: {
+            // No integer division in SIMD; inactive lanes are skipped so they
+            // cannot trap, and b == -1 is handled without INT_MIN overflow
+            int32_t b[BATCH_BLOCK];
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            batch_eval(node->children[1], mask, st, call_depth, b);
+            for (int i = 0; i < BATCH_BLOCK; i++) {
+                if (!mask[i] || b[i] == 0) {
+                    out[i] = 0;
+                } else if (b[i] == -1) {
+                    out[i] = (node->op == OP_DIV) ? (int32_t)(0u - (uint32_t)out[i]) : 0;
+                } else {
+                    out[i] = (node->op == OP_DIV) ? out[i] / b[i] : out[i] % b[i];
+                }
+            }
+            break;
+        }
+        case OP_SIN:
+        case OP_TANH:
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            for (int i = 0; i < BATCH_BLOCK; i++) {
+                if (!mask[i]) continue;
+                double x = (double)out[i] / 100.0;
+                out[i] = (int)(((node->op == OP_SIN) ? sin(x) : tanh(x)) * 100.0);
+            }
+            break;
+        case OP_IDENT:
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            break;
+        case OP_CONST:
+            batch_fill(out, node->value);
+            break;
+        case OP_INPUT: {
+            int idx = node->value;
+            if (idx >= 0 && idx < st->num_inputs && idx < MAX_INPUTS) {
+                memcpy(out, st->inputs[idx], sizeof(int32_t) * BATCH_BLOCK);
+            } else {
+                batch_fill(out, 0);
+            }
+            break;
+        }
+        case OP_OUTPUT: {
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            for (int i = 0; i < BATCH_BLOCK; i++) {
+                if (mask[i] && st->num_outputs[i] < MAX_OUTPUTS) {
+                    st->outputs[st->num_outputs[i]++][i] = out[i];
+                }
+            }
+            batch_fill(out, 0);
+            break;
+        }
+        case OP_IF_GT: {
+            int32_t a[BATCH_BLOCK];
+            int32_t b[BATCH_BLOCK];
+            batch_eval(node->children[0], mask, st, call_depth, a);
+            batch_eval(node->children[1], mask, st, call_depth, b);
+            st->k->binary(K_GT_MASK, a, a, b);
+            batch_eval_branches(node->children[2], node->children[3], a, mask, st, call_depth, out);
+            break;
+        }
+        case OP_IF: {
+            int32_t cond[BATCH_BLOCK];
+            batch_eval(node->children[0], mask, st, call_depth, cond);
+            st->k->unary(K_NONZERO, cond, cond);
+            batch_eval_branches(node->children[1], node->children[2], cond, mask, st, call_depth, out);
+            break;
+        }
+        case OP_SEQ:
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            batch_eval(node->children[1], mask, st, call_depth, out);
+            batch_fill(out, 0);
+            break;
+        case OP_LIBRARY: {
+            int idx = node->value;
+            if (st->pop && idx >= 0 && idx < st->pop->library_size) {
+                batch_call_library(idx, mask, st, call_depth, out);
+            } else {
+                batch_fill(out, 0);
+            }
+            break;
+        }
+        case OP_MEM_READ: {
+            int idx = node->value;
+            if (idx >= 0 && idx < MAX_MEMORY) {
+                memcpy(out, st->memory[idx], sizeof(int32_t) * BATCH_BLOCK);
+            } else {
+                batch_fill(out, 0);
+            }
+            break;
+        }
+        case OP_MEM_WRITE: {
+            int idx = node->value;
+            batch_eval(node->children[0], mask, st, call_depth, out);
+            if (idx >= 0 && idx < MAX_MEMORY) {
+                st->k->blend(st->memory[idx], mask, out, st->memory[idx]);
+            }
+            batch_fill(out, 0);
+            break;
+        }
+        case OP_FUNC_CALL: {
+            int func_idx = node->value;
+            Population* pop = st->pop;
+            if (!pop || func_idx < 0 || func_idx >= pop->library_size) {
+                batch_fill(out, 0);
+                break;
+            }
+            LibraryEntry* func = &pop->library[func_idx];
+
+            int old_stack_ptr = st->arg_stack_ptr;
+            int old_frame_base = st->arg_frame_base;
+
+            for (int i = 0; i < func->num_params && i < node->num_children; i++) {
+                batch_eval(node->children[i], mask, st, call_depth, out);
+                if (st->arg_stack_ptr < BATCH_ARGS_CAPACITY) {
+                    memcpy(st->args[st->arg_stack_ptr], out, sizeof(int32_t) * BATCH_BLOCK);
+                }
+                st->arg_stack_ptr++;
+            }
+
+            st->arg_frame_base = old_stack_ptr;
+            batch_call_library(func_idx, mask, st, call_depth, out);
+
+            st->arg_stack_ptr = old_stack_ptr;
+            st->arg_frame_base = old_frame_base;
+            break;
+        }
+        case OP_PARAM: {
+            int arg_pos = st->arg_frame_base + node->value;
+            if (arg_pos >= 0 && arg_pos < st->arg_stack_ptr && arg_pos < BATCH_ARGS_CAPACITY) {
+                memcpy(out, st->args[arg_pos], sizeof(int32_t) * BATCH_BLOCK);
+            } else {
+                batch_fill(out, 0);
+            }
+            break;
+        }
+        default:
+            batch_fill(out, 0);
+            break;
+    }
+}
+
+// Run a program on every case of a batch. Like execute_program, outputs are
+// reset per call and memory columns persist between calls.
+void execute_program_batch(Program* prog, BatchContext* batch, Population* pop) {
+    pthread_once(&batch_kernels_once, batch_select_kernels);
+
+    BatchState* st = malloc(sizeof(BatchState));
+    st->k = batch_kernels;
+    st->pop = pop;
+    st->num_inputs = batch->num_inputs;
+
+    int32_t mask[BATCH_BLOCK];
+    int32_t result[BATCH_BLOCK];
+
+    for (int start = 0; start < batch->num_cases; start += BATCH_BLOCK) {
+        int n = batch->num_cases - start;
+        if (n > BATCH_BLOCK) n = BATCH_BLOCK;
+        size_t bytes = sizeof(int32_t) * n;
+
+        // Load the block; padding lanes are zero and masked off
+        memset(st->inputs, 0, sizeof(st->inputs));
+        memset(st->memory, 0, sizeof(st->memory));
+        for (int i = 0; i < batch->num_inputs && i < MAX_INPUTS; i++) {
+            memcpy(st->inputs[i], batch->inputs[i] + start, bytes);
+        }
+        for (int i = 0; i < MAX_MEMORY; i++) {
+            memcpy(st->memory[i], batch->memory[i] + start, bytes);
+        }
+        memset(st->num_outputs, 0, sizeof(st->num_outputs));
+        st->arg_stack_ptr = 0;
+        st->arg_frame_base = 0;
+        for (int i = 0; i < BATCH_BLOCK; i++) mask[i] = (i < n) ? -1 : 0;
+
+        if (prog && prog->root) {
+            batch_eval(prog->root, mask, st, 0, result);
+            gp_count_nodes((uint64_t)prog->size * n);
+        }
+
+        // Store the block back
+        for (int i = 0; i < MAX_MEMORY; i++) {
+            memcpy(batch->memory[i] + start, st->memory[i], bytes);
+        }
+        for (int k = 0; k < MAX_OUTPUTS; k++) {
+            memcpy(batch->outputs[k] + start, st->outputs[k], bytes);
+        }
+        memcpy(batch->num_outputs + start, st->num_outputs, bytes);
+    }
+
+    free(st);
+}
@@ -0,0 +1,217 @@
+#include "gp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Island model
+//
+// Islands only meet at migrations. A mailbox is a Treiber stack: senders
+// push with a CAS, and the owning island takes the whole list with one
+// exchange, so neither side ever blocks and there is no ABA problem (nodes
+// are never popped individually).
+
+typedef struct Migrant {
+    Program* prog;
+    struct Migrant* next;
+} Migrant;
+
+typedef struct {
+    Population* pop;
+    Migrant* inbox;
+    Rng rng;                    // Picks destinations for TOPOLOGY_RANDOM
+    uint64_t migrants_sent;
+    uint64_t migrants_received;
+} __attribute__((aligned(64))) Island;
+
+struct IslandModel {
+    IslandConfig cfg;
+    int num_islands;
+    Island* islands;
+    ThreadPool* pool;
+    int stop;                   // Set once an island reaches target_fitness
+};
+
+void island_config_default(IslandConfig* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->migration_interval = 10;
+    cfg->num_migrants = 5;
+    cfg->topology = TOPOLOGY_RING;
+    cfg->target_fitness = INFINITY;
+    pop_config_default(&cfg->pop);
+}
+
+IslandModel* island_create(const IslandConfig* cfg) {
+    IslandModel* model = calloc(1, sizeof(IslandModel));
+    model->cfg = *cfg;
+    model->num_islands = cfg->num_islands > 0 ? cfg->num_islands : gp_available_cpus();
+    if (model->cfg.migration_interval < 1) model->cfg.migration_interval = 1;
+    model->islands = aligned_alloc(64, sizeof(Island) * model->num_islands);
+    memset(model->islands, 0, sizeof(Island) * model->num_islands);
+
+    // Island 0 resolves the run seed; the others derive theirs from it
+    PopConfig pop_cfg = cfg->pop;
+    pop_cfg.num_threads = 1;
+    for (int i = 0; i < model->num_islands; i++) {
+        Island* island = &model->islands[i];
+        if (i > 0) pop_cfg.seed = rng_derive(model->islands[0].pop->seed, (uint64_t)i, 0);
+        island->pop = pop_create_config(&pop_cfg);
+        rng_seed(&island->rng, rng_derive(island->pop->seed, 0x6d696772ULL, 0));
+    }
+
+    model->pool = pool_create(model->num_islands, cfg->pin_threads);
+    return model;
+}
+
+static void free_migrants(Migrant* m) {
+    while (m) {
+        Migrant* next = m->next;
+        prog_destroy(m->prog);
+        free(m);
+        m = next;
+    }
+}
+
+void island_destroy(IslandModel* model) {
+    if (!model) return;
+    pool_destroy(model->pool);
+    for (int i = 0; i < model->num_islands; i++) {
+        free_migrants(model->islands[i].inbox);
+        pop_destroy(model->islands[i].pop);
+    }
+    free(model->islands);
+    free(model);
+}
+
+static void mailbox_push(Island* island, Migrant* m) {
+    Migrant* head = __atomic_load_n(&island->inbox, __ATOMIC_RELAXED);
+    do {
+        m->next = head;
+    } while (!__atomic_compare_exchange_n(&island->inbox, &head, m, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static Migrant* mailbox_take_all(Island* island) {
+    return __atomic_exchange_n(&island->inbox, NULL, __ATOMIC_ACQUIRE);
+}
+
+// Send copies of the island's elites (programs[0..elite_size) are the
+// previous generation's best, in rank order) to one destination
+static void send_to(IslandModel* model, Island* island, int dest, int count) {
+    for (int i = 0; i < count; i++) {
+        Migrant* m = malloc(sizeof(Migrant));
+        m->prog = calloc(1, sizeof(Program));
+        m->prog->root = node_inline_library(island->pop->programs[i]->root, island->pop);
+        m->prog->fitness = island->pop->programs[i]->fitness;
+        prog_update_metadata(m->prog);
+        mailbox_push(&model->islands[dest], m);
+        island->migrants_sent++;
+    }
+}
+
+static void send_migrants(IslandModel* model, int idx) {
+    Island* island = &model->islands[idx];
+    int n = model->num_islands;
+    int count = model->cfg.num_migrants;
+    if (count > island->pop->elite_size) count = island->pop->elite_size;
+    if (n < 2 || count <= 0) return;
+
+    switch (model->cfg.topology) {
+        case TOPOLOGY_RING:
+            send_to(model, island, (idx + 1) % n, count);
+            break;
+        case TOPOLOGY_RANDOM: {
+            int dest = rng_int(&island->rng, n - 1);
+            send_to(model, island, dest >= idx ? dest + 1 : dest, count);
+            break;
+        }
+        case TOPOLOGY_FULL:
+            for (int dest = 0; dest < n; dest++) {
+                if (dest != idx) send_to(model, island, dest, count);
+            }
+            break;
+    }
+}
+
+// Swap arrived migrants in for the last (non-elite) programs
+static void receive_migrants(Island* island) {
+    Population* pop = island->pop;
+    if (!pop->programs[0]) return;  // Not initialized yet; keep them queued
+
+    Migrant* m = mailbox_take_all(island);
+    int slot = pop->pop_size - 1;
+    while (m) {
+        Migrant* next = m->next;
+        if (slot >= pop->elite_size) {
+            prog_destroy(pop->programs[slot]);
+            pop->programs[slot--] = m->prog;
+            island->migrants_received++;
+        } else {
+            prog_destroy(m->prog);
+        }
+        free(m);
+        m = next;
+    }
+}
+
+typedef struct {
+    IslandModel* model;
+    FitnessFn fitness_fn;
+    void* data;
+    int num_inputs;
+    int generations;
+} IslandJob;
+
+// Pool task: worker w evolves islands w, w + num_workers, ...
+static void island_task(void* arg, int worker, int num_workers) {
+    IslandJob* job = (IslandJob*)arg;
+    IslandModel* model = job->model;
+
+    for (int idx = worker; idx < model->num_islands; idx += num_workers) {
+        Island* island = &model->islands[idx];
+        Population* pop = island->pop;
+
+        for (int g = 0; g < job->generations; g++) {
+            if (__atomic_load_n(&model->stop, __ATOMIC_RELAXED)) break;
+
+            receive_migrants(island);
+            evolve_generation(pop, job->fitness_fn, job->data, job->num_inputs);
+
+            if (pop->best_fitness >= model->cfg.target_fitness) {
+                __atomic_store_n(&model->stop, 1, __ATOMIC_RELAXED);
+            }
+            if (pop->generation % model->cfg.migration_interval == 0) {
+                send_migrants(model, idx);
+            }
+        }
+    }
+}
+
+// Run every island for up to `generations` more generations
+void island_evolve(IslandModel* model, FitnessFn fitness_fn, void* data, int num_inputs, int generations) {
+    IslandJob job = {model, fitness_fn, data, num_inputs, generations};
+    pool_run(model->pool, island_task, &job);
+}
+
+int island_count(IslandModel* model) {
+    return model->num_islands;
+}
+
+Population* island_population(IslandModel* model, int island) {
+    return model->islands[island].pop;
+}
+
+int island_best_index(IslandModel* model) {
+    int best = 0;
+    for (int i = 1; i < model->num_islands; i++) {
+        if (model->islands[i].pop->best_fitness > model->islands[best].pop->best_fitness) best = i;
+    }
+    return best;
+}
+
+void island_stats(IslandModel* model, int island, IslandStats* stats) {
+    Island* isl = &model->islands[island];
+    stats->generation = isl->pop->generation;
+    stats->best_fitness = isl->pop->best_fitness;
+    stats->migrants_sent = isl->migrants_sent;
+    stats->migrants_received = isl->migrants_received;
+}
@@ -0,0 +1,359 @@
+#include "gp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Linear genomes
+//
+// A node's children follow it back to back, each taking its extent in
+// entries, so the walk from a node to its k-th child only adds extents and
+// never leaves the array. execute_linear evaluates in that order: it reads
+// the array front to back and jumps over the IF/IF_GT branch it doesn't
+// take. Library bodies are still trees and run through execute_node.
+
+static LinearTree* linear_alloc(int length) {
+    LinearTree* lt = calloc(1, sizeof(LinearTree));
+    lt->nodes = malloc(sizeof(LinearNode) * (length > 0 ? length : 1));
+    lt->length = length;
+    return lt;
+}
+
+void linear_destroy(LinearTree* lt) {
+    if (!lt) return;
+    free(lt->nodes);
+    free(lt);
+}
+
+LinearTree* linear_copy(const LinearTree* lt) {
+    if (!lt) return NULL;
+    LinearTree* copy = linear_alloc(lt->length);
+    memcpy(copy->nodes, lt->nodes, sizeof(LinearNode) * lt->length);
+    copy->size = lt->size;
+    copy->depth = lt->depth;
+    return copy;
+}
+
+// Conversion
+
+static int tree_entries(Node* node) {
+    if (!node) return 1;
+    int n = 1;
+    for (int i = 0; i < node->num_children; i++) n += tree_entries(node->children[i]);
+    return n;
+}
+
+// Append node's subtree at *pos; returns its depth
+static int linear_emit(LinearNode* nodes, int* pos, Node* node) {
+    LinearNode* e = &nodes[(*pos)++];
+    if (!node) {
+        *e = (LinearNode){LINEAR_NONE, 0, 0, 0, 1};
+        return 0;
+    }
+    int start = *pos - 1;
+    int max_child_depth = 0;
+    e->op = node->op;
+    e->num_children = node->num_children;
+    e->value = node->value;
+    for (int i = 0; i < node->num_children; i++) {
+        int d = linear_emit(nodes, pos, node->children[i]);
+        if (d > max_child_depth) max_child_depth = d;
+    }
+    e->extent = *pos - start;
+    e->depth = (uint16_t)(1 + max_child_depth < UINT16_MAX ? 1 + max_child_depth : UINT16_MAX);
+    return 1 + max_child_depth;
+}
+
+LinearTree* linear_from_tree(Node* root) {
+    if (!root) return linear_alloc(0);
+    LinearTree* lt = linear_alloc(tree_entries(root));
+    int pos = 0;
+    lt->depth = linear_emit(lt->nodes, &pos, root);
+    lt->size = node_size(root);
+    return lt;
+}
+
+static Node* linear_build(const LinearNode* nodes, int* pos) {
+    const LinearNode* e = &nodes[(*pos)++];
+    if (e->op == LINEAR_NONE) return NULL;
+    Node* node = node_create((OpType)e->op, e->value);
+    node->num_children = e->num_children;
+    for (int i = 0; i < e->num_children; i++) node->children[i] = linear_build(nodes, pos);
+    return node;
+}
+
+Node* linear_to_tree(const LinearTree* lt) {
+    if (!lt || lt->length == 0) return NULL;
+    int pos = 0;
+    return linear_build(lt->nodes, &pos);
+}
+
+// Execution
+
+typedef struct {
+    Context* ctx;
+    Population* pop;
+    uint64_t executed;
+} LinearRun;
+
+static int linear_eval(LinearRun* run, const LinearNode* e);
+
+// Children of the node being evaluated are consumed in order: *pos is the
+// next one and *left how many remain. Past the last child a node reads 0,
+// as execute_node does for a NULL child.
+static inline int linear_arg(LinearRun* run, const LinearNode** pos, int* left) {
+    if (*left <= 0) return 0;
+    const LinearNode* e = *pos;
+    *pos += e->extent;
+    (*left)--;
+    return linear_eval(run, e);
+}
+
+static inline void linear_skip(const LinearNode** pos, int* left) {
+    if (*left <= 0) return;
+    *pos += (*pos)->extent;
+    (*left)--;
+}
+
+static int linear_eval(LinearRun* run, const LinearNode* e) {
+    if (e->op == LINEAR_NONE) return 0;
+    run->executed += GP_NODE_COUNT;
+#ifdef GP_PROFILE
+    gp_profile_count((OpType)e->op, 1);
+#endif
+    Context* ctx = run->ctx;
+    const LinearNode* pos = e + 1;
+    int left = e->num_children;
+
+    switch (e->op) {
+        case OP_ADD: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a + b;
+        }
+        case OP_SUB: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a - b;
+        }
+        case OP_MUL: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a * b;
+        }
+        case OP_DIV: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (b != 0) ? (a / b) : 0;
+        }
+        case OP_MOD: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (b != 0) ? (a % b) : 0;
+        }
+        case OP_AND: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a & b;
+        }
+        case OP_OR: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a | b;
+        }
+        case OP_XOR: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return a ^ b;
+        }
+        case OP_NOT:
+            return ~linear_arg(run, &pos, &left);
+        case OP_EQ: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a == b) ? 1 : 0;
+        }
+        case OP_LT: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a < b) ? 1 : 0;
+        }
+        case OP_LTE: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a <= b) ? 1 : 0;
+        }
+        case OP_ABS: {
+            int a = linear_arg(run, &pos, &left);
+            return (a < 0) ? -a : a;
+        }
+        case OP_NEG:
+            return -linear_arg(run, &pos, &left);
+        case OP_MAX: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a > b) ? a : b;
+        }
+        case OP_MIN: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a < b) ? a : b;
+        }
+        case OP_GT: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            return (a > b) ? 1 : 0;
+        }
+        case OP_SIN: {
+            // Scale: a/100 radians, result *100
+            double rad = (double)linear_arg(run, &pos, &left) / 100.0;
+            return (int)(sin(rad) * 100.0);
+        }
+        case OP_TANH: {
+            // Scale: a/100, result *100
+            double x = (double)linear_arg(run, &pos, &left) / 100.0;
+            return (int)(tanh(x) * 100.0);
+        }
+        case OP_STEP:
+            return (linear_arg(run, &pos, &left) > 0) ? 1 : 0;
+        case OP_IDENT:
+            return linear_arg(run, &pos, &left);
+        case OP_CONST:
+            return e->value;
+        case OP_INPUT:
+            if (e->value >= 0 && e->value < ctx->num_inputs) return ctx->inputs[e->value];
+            return 0;
+        case OP_OUTPUT: {
+            int val = linear_arg(run, &pos, &left);
+            if (ctx->num_outputs < MAX_OUTPUTS) ctx->outputs[ctx->num_outputs++] = val;
+            return 0;
+        }
+        case OP_IF_GT: {
+            int a = linear_arg(run, &pos, &left);
+            int b = linear_arg(run, &pos, &left);
+            if (!(a > b)) linear_skip(&pos, &left);
+            return linear_arg(run, &pos, &left);
+        }
+        case OP_IF: {
+            int cond = linear_arg(run, &pos, &left);
+            if (cond == 0) linear_skip(&pos, &left);
+            return linear_arg(run, &pos, &left);
+        }
+        case OP_SEQ:
+            linear_arg(run, &pos, &left);
+            linear_arg(run, &pos, &left);
+            return 0;
+        case OP_LIBRARY: {
+            Population* pop = run->pop;
+            if (pop && e->value >= 0 && e->value < pop->library_size) {
+                return execute_node(pop->library[e->value].tree, ctx, pop);
+            }
+            return 0;
+        }
+        case OP_MEM_READ:
+            if (e->value >= 0 && e->value < MAX_MEMORY) return ctx->memory[e->value];
+            return 0;
+        case OP_MEM_WRITE: {
+            int val = linear_arg(run, &pos, &left);
+            if (e->value >= 0 && e->value < MAX_MEMORY) ctx->memory[e->value] = val;
+            return 0;
+        }
+        case OP_FUNC_CALL: {
+            Population* pop = run->pop;
+            if (!pop || e->value < 0 || e->value >= pop->library_size) return 0;
+            LibraryEntry* func = &pop->library[e->value];
+
+            // Same argument frame handling as execute_node
+            int old_stack_ptr = ctx->arg_stack_ptr;
+            int old_frame_base = ctx->arg_frame_base;
+            for (int k = 0; k < func->num_params && k < e->num_children; k++) {
+                int arg = linear_arg(run, &pos, &left);
+                ctx->args[ctx->arg_stack_ptr++] = arg;
+            }
+            ctx->arg_frame_base = old_stack_ptr;
+            int result = execute_node(func->tree, ctx, pop);
+            ctx->arg_stack_ptr = old_stack_ptr;
+            ctx->arg_frame_base = old_frame_base;
+            return result;
+        }
+        case OP_PARAM: {
+            int arg_pos = ctx->arg_frame_base + e->value;
+            if (arg_pos >= 0 && arg_pos < ctx->arg_stack_ptr) return ctx->args[arg_pos];
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+int execute_linear(const LinearTree* lt, Context* ctx, Population* pop) {
+    if (!lt || lt->length == 0) return 0;
+    LinearRun run = {ctx, pop, 0};
+    int result = linear_eval(&run, lt->nodes);
+    gp_count_nodes(run.executed);
+    return result;
+}
+
+// Crossover
+
+static int count_nodes(const LinearNode* nodes, int begin, int end) {
+    int n = 0;
+    for (int i = begin; i < end; i++) n += nodes[i].op != LINEAR_NONE;
+    return n;
+}
+
+LinearTree* linear_splice(const LinearTree* dst, int at, const LinearTree* src, int from) {
+    int cut = dst->nodes[at].extent;
+    int graft = src->nodes[from].extent;
+    int tail = dst->length - at - cut;
+    LinearTree* lt = linear_alloc(at + graft + tail);
+    LinearNode* nodes = lt->nodes;
+    memcpy(nodes, dst->nodes, sizeof(LinearNode) * at);
+    memcpy(nodes + at, src->nodes + from, sizeof(LinearNode) * graft);
+    memcpy(nodes + at + graft, dst->nodes + at + cut, sizeof(LinearNode) * tail);
+
+    // Only the ancestors of the splice point change: they are the entries
+    // before it whose range covers it. Deepest first, so each one's depth
+    // comes from children that are already correct.
+    for (int i = at - 1; i >= 0; i--) {
+        if (i + nodes[i].extent <= at) continue;
+        nodes[i].extent += graft - cut;
+        int max_child_depth = 0;
+        for (int k = 0, j = i + 1; k < nodes[i].num_children; k++, j += nodes[j].extent) {
+            if (nodes[j].depth > max_child_depth) max_child_depth = nodes[j].depth;
+        }
+        nodes[i].depth = (uint16_t)(1 + max_child_depth < UINT16_MAX ? 1 + max_child_depth : UINT16_MAX);
+    }
+    lt->size = dst->size - count_nodes(dst->nodes, at, at + cut) + count_nodes(src->nodes, from, from + graft);
+    lt->depth = nodes[0].depth;
+    return lt;
+}
+
+// The entry get_random_node picks in gp.c, with the same draws: walk down
+// through first present children, stopping at a node with probability
+// 1/count or at a leaf
+static int linear_random_node(const LinearTree* lt) {
+    const LinearNode* nodes = lt->nodes;
+    int count = 0;
+    int i = 0;
+    for (;;) {
+        if (rng_int(gp_rng(), ++count) == 0) return i;
+        int j = i + 1;
+        int k = 0;
+        while (k < nodes[i].num_children && nodes[j].op == LINEAR_NONE) {
+            j += nodes[j].extent;
+            k++;
+        }
+        if (k == nodes[i].num_children) return i;
+        i = j;
+    }
+}
+
+LinearTree* linear_crossover(const LinearTree* p1, const LinearTree* p2) {
+    if (p1->length == 0 || p2->length == 0 || p1->nodes[0].op == LINEAR_NONE ||
+        p2->nodes[0].op == LINEAR_NONE) {
+        return linear_copy(p1);
+    }
+    int at = linear_random_node(p1);
+    int from = linear_random_node(p2);
+    return linear_splice(p1, at, p2, from);
+}
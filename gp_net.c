@@ -0,0 +1,687 @@
+#include "gp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// Multi-process migration
+//
+// Island processes connect to one coordinator, which relays migrant frames
+// between them according to the topology. Programs travel in a compact
+// pre-order encoding; library calls are inlined before sending since each
+// process learns its own library.
+
+// Program encoding
+//
+//   byte    SERIAL_VERSION
+//   varint  node count
+//   u32     fitness (IEEE bits, little endian)
+//   nodes in pre-order, each:
+//     byte    op | NODE_HAS_VALUE if value != 0
+//     byte    num_children (OP_FUNC_CALL only; other ops have fixed arity)
+//     varint  zigzag(value) (only with NODE_HAS_VALUE)
+//   or, for a missing child (which executes as 0):
+//     byte    NODE_MISSING (not included in the node count)
+//
+// Operators therefore cost one byte and most terminals two or three.
+
+#define SERIAL_VERSION 1
+#define SERIAL_MAX_DEPTH 512
+#define NODE_HAS_VALUE 0x80
+#define NODE_MISSING 0x7f
+
+_Static_assert(OP_COUNT <= 0x40, "opcode must fit below NODE_HAS_VALUE and NODE_MISSING");
+
+typedef struct {
+    uint8_t* buf;
+    size_t cap;
+    size_t len;     // Bytes produced, including any that did not fit
+} Writer;
+
+typedef struct {
+    const uint8_t* buf;
+    size_t len;
+    size_t pos;
+    int nodes_left;
+    int error;
+} Reader;
+
+static void put_byte(Writer* w, uint8_t b) {
+    if (w->len < w->cap) w->buf[w->len] = b;
+    w->len++;
+}
+
+static void put_varint(Writer* w, uint64_t v) {
+    while (v >= 0x80) {
+        put_byte(w, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    put_byte(w, (uint8_t)v);
+}
+
+static void put_u32(Writer* w, uint32_t v) {
+    for (int i = 0; i < 4; i++) put_byte(w, (uint8_t)(v >> (8 * i)));
+}
+
+static void put_u64(Writer* w, uint64_t v) {
+    for (int i = 0; i < 8; i++) put_byte(w, (uint8_t)(v >> (8 * i)));
+}
+
+static uint8_t get_byte(Reader* r) {
+    if (r->pos >= r->len) {
+        r->error = 1;
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+static uint64_t get_varint(Reader* r) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b = get_byte(r);
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    r->error = 1;
+    return 0;
+}
+
+static uint32_t get_u32(Reader* r) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)get_byte(r) << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(Reader* r) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)get_byte(r) << (8 * i);
+    return v;
+}
+
+static void write_node(Writer* w, Node* node) {
+    if (!node) {
+        put_byte(w, NODE_MISSING);
+        return;
+    }
+    put_byte(w, node->op | (node->value ? NODE_HAS_VALUE : 0));
+    if (node->op == OP_FUNC_CALL) put_byte(w, node->num_children);
+    if (node->value) {
+        int64_t v = node->value;
+        put_varint(w, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        write_node(w, node->children[i]);
+    }
+}
+
+size_t prog_serialize(const Program* prog, uint8_t* buf, size_t cap) {
+    Writer w = {buf, cap, 0};
+    uint32_t fitness_bits;
+    memcpy(&fitness_bits, &prog->fitness, sizeof(fitness_bits));
+
+    put_byte(&w, SERIAL_VERSION);
+    put_varint(&w, (uint64_t)node_size(prog->root));
+    put_u32(&w, fitness_bits);
+    write_node(&w, prog->root);
+    return w.len;
+}
+
+static Node* read_node(Reader* r, int depth) {
+    if (depth > SERIAL_MAX_DEPTH) {
+        r->error = 1;
+        return NULL;
+    }
+    uint8_t tag = get_byte(r);
+    if (tag == NODE_MISSING) return NULL;
+    int op = tag & ~NODE_HAS_VALUE;
+    if (r->error || op >= OP_COUNT || r->nodes_left-- <= 0) {
+        r->error = 1;
+        return NULL;
+    }
+
+    Node* node = node_create(op, 0);
+    if (op == OP_FUNC_CALL) {
+        node->num_children = get_byte(r);
+        if (node->num_children > MAX_CHILDREN) {
+            node->num_children = 0;
+            r->error = 1;
+        }
+    }
+    if (tag & NODE_HAS_VALUE) {
+        uint64_t z = get_varint(r);
+        node->value = (int)(int64_t)((z >> 1) ^ -(z & 1));
+    }
+    for (int i = 0; i < node->num_children && !r->error; i++) {
+        node->children[i] = read_node(r, depth + 1);
+    }
+    return node;
+}
+
+Program* prog_deserialize(const uint8_t* buf, size_t len, size_t* used) {
+    Reader r = {buf, len, 0, 0, 0};
+    if (get_byte(&r) != SERIAL_VERSION) return NULL;
+    uint64_t count = get_varint(&r);
+    uint32_t fitness_bits = get_u32(&r);
+    if (r.error || count == 0 || count > (uint64_t)len) return NULL;
+
+    r.nodes_left = (int)count;
+    Node* root = read_node(&r, 1);
+    if (r.error || r.nodes_left != 0) {
+        node_destroy(root);
+        return NULL;
+    }
+
+    Program* prog = calloc(1, sizeof(Program));
+    prog->root = root;
+    memcpy(&prog->fitness, &fitness_bits, sizeof(prog->fitness));
+    prog_update_metadata(prog);
+    if (used) *used = r.pos;
+    return prog;
+}
+
+// Framing
+//
+// Every message is a u32 length (of what follows) and a type byte.
+//   HELLO     island -> coordinator, no payload
+//   WELCOME   coordinator -> island: u32 island id, u32 island count
+//   MIGRANTS  u64 send time (ns, CLOCK_REALTIME), u32 sender, u32 count,
+//             then count encoded programs. The coordinator forwards the
+//             frame unchanged, so latency is measured sender to receiver.
+
+enum { MSG_HELLO = 1, MSG_WELCOME = 2, MSG_MIGRANTS = 3 };
+
+#define FRAME_HEADER 5
+#define FRAME_MAX (16u << 20)
+#define MIGRANTS_HEADER (FRAME_HEADER + 16)
+#define READ_MAX (4 + FRAME_MAX + 65536)   // Unread input kept per link: a largest frame plus one read
+#define LINK_OUT_MAX (8u << 20)            // Relayed bytes queued for one island before frames are dropped
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void record_latency(MigrationLinkStats* stats, uint64_t sent_ns) {
+    uint64_t now = wall_ns();
+    double latency = now > sent_ns ? (now - sent_ns) / 1e9 : 0.0;
+    stats->latency_total += latency;
+    if (latency > stats->latency_max) stats->latency_max = latency;
+}
+
+// Growable byte buffer
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} Buffer;
+
+static void buffer_reserve(Buffer* b, size_t extra) {
+    if (b->len + extra <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    b->data = realloc(b->data, cap);
+    b->cap = cap;
+}
+
+static void buffer_append(Buffer* b, const uint8_t* data, size_t n) {
+    buffer_reserve(b, n);
+    memcpy(b->data + b->len, data, n);
+    b->len += n;
+}
+
+static void buffer_consume(Buffer* b, size_t n) {
+    memmove(b->data, b->data + n, b->len - n);
+    b->len -= n;
+}
+
+// Length of the complete frame at the start of b, 0 if incomplete, -1 if invalid
+static long buffer_frame(Buffer* b) {
+    if (b->len < FRAME_HEADER) return 0;
+    Reader r = {b->data, b->len, 0, 0, 0};
+    uint32_t n = get_u32(&r);
+    if (n < 1 || n > FRAME_MAX) return -1;
+    return b->len >= 4 + (size_t)n ? 4 + (long)n : 0;
+}
+
+// Read what is available without blocking, up to READ_MAX buffered bytes;
+// the rest waits in the socket for the next call. Returns 0 on EOF or error.
+static int buffer_fill(Buffer* b, int fd) {
+    for (;;) {
+        if (b->len >= READ_MAX) return 1;
+        size_t room = READ_MAX - b->len < 65536 ? READ_MAX - b->len : 65536;
+        buffer_reserve(b, room);
+        ssize_t n = recv(fd, b->data + b->len, room, MSG_DONTWAIT);
+        if (n > 0) {
+            b->len += n;
+            continue;
+        }
+        if (n == 0) return 0;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+static int send_all(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Sockets
+//
+// Addresses are "unix:/path/to/socket" or "tcp:host:port" (an empty host
+// listens on every interface, or connects to localhost).
+
+static int open_socket(const char* address, int listening) {
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        if (strlen(address + 5) >= sizeof(sa.sun_path)) return -1;
+        strcpy(sa.sun_path, address + 5);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (listening) {
+            unlink(sa.sun_path);
+            if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0 && listen(fd, 64) == 0) return fd;
+        } else if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0) {
+            return fd;
+        }
+        close(fd);
+        return -1;
+    }
+
+    if (strncmp(address, "tcp:", 4) == 0) {
+        char host[256];
+        const char* colon = strrchr(address + 4, ':');
+        if (!colon || (size_t)(colon - (address + 4)) >= sizeof(host)) return -1;
+        memcpy(host, address + 4, colon - (address + 4));
+        host[colon - (address + 4)] = '\0';
+
+        struct addrinfo hints, *res;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        if (getaddrinfo(host[0] ? host : NULL, colon + 1, &hints, &res) != 0) return -1;
+
+        int fd = -1;
+        for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+            fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (listening) {
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) break;
+            } else if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                break;
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(res);
+        return fd;
+    }
+
+    return -1;
+}
+
+static int accept_link(int listen_fd) {
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd >= 0 || errno != EINTR) return fd;
+    }
+}
+
+// Coordinator
+
+typedef struct {
+    int fd;                     // -1 once the island has disconnected
+    Buffer in;
+    Buffer out;                 // Frames waiting for the socket to drain
+    MigrationLinkStats stats;
+} Link;
+
+static void link_close(Link* link) {
+    if (link->fd >= 0) close(link->fd);
+    link->fd = -1;
+    link->out.len = 0;
+}
+
+static void forward(Link* links, int dest, const uint8_t* frame, size_t len, uint32_t count) {
+    Link* link = &links[dest];
+    if (link->fd < 0) return;
+    // An island that stops reading loses migrants rather than growing the
+    // queue without bound; whole frames only, so the stream stays in sync
+    if (link->out.len > 0 && link->out.len + len > LINK_OUT_MAX) {
+        link->stats.frames_dropped++;
+        return;
+    }
+    buffer_append(&link->out, frame, len);
+    link->stats.bytes_sent += len;
+    link->stats.frames_sent++;
+    link->stats.migrants_sent += count;
+}
+
+static void relay(Link* links, int n, int from, MigrationTopology topology, Rng* rng,
+                  const uint8_t* frame, size_t len) {
+    Reader r = {frame, len, FRAME_HEADER, 0, 0};
+    uint64_t sent_ns = get_u64(&r);
+    get_u32(&r);
+    uint32_t count = get_u32(&r);
+    if (r.error) return;
+
+    Link* src = &links[from];
+    src->stats.bytes_received += len;
+    src->stats.frames_received++;
+    src->stats.migrants_received += count;
+    record_latency(&src->stats, sent_ns);
+
+    if (n < 2) return;
+    switch (topology) {
+        case TOPOLOGY_RING:
+            forward(links, (from + 1) % n, frame, len, count);
+            break;
+        case TOPOLOGY_RANDOM: {
+            int dest = rng_int(rng, n - 1);
+            forward(links, dest >= from ? dest + 1 : dest, frame, len, count);
+            break;
+        }
+        case TOPOLOGY_FULL:
+            for (int dest = 0; dest < n; dest++) {
+                if (dest != from) forward(links, dest, frame, len, count);
+            }
+            break;
+    }
+}
+
+// Handle everything island i has sent. Returns 0 if the link must be closed.
+static int link_read(Link* links, int n, int i, MigrationTopology topology, Rng* rng) {
+    Link* link = &links[i];
+    int open = buffer_fill(&link->in, link->fd);
+    long len;
+    while ((len = buffer_frame(&link->in)) > 0) {
+        if (link->in.data[4] == MSG_MIGRANTS && len >= MIGRANTS_HEADER) {
+            relay(links, n, i, topology, rng, link->in.data, len);
+        }
+        buffer_consume(&link->in, len);
+    }
+    return open && len == 0;
+}
+
+static int link_write(Link* link) {
+    while (link->out.len > 0) {
+        ssize_t n = send(link->fd, link->out.data, link->out.len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        buffer_consume(&link->out, n);
+    }
+    return 1;
+}
+
+int migration_coordinator_run(const char* address, int num_islands, MigrationTopology topology,
+                              MigrationLinkStats* link_stats) {
+    int listen_fd = open_socket(address, 1);
+    if (listen_fd < 0 || num_islands < 1) {
+        if (listen_fd >= 0) close(listen_fd);
+        return -1;
+    }
+
+    // Islands get their ids in connection order, and nobody starts until
+    // everyone is there, so the first migration always has a destination
+    Link* links = calloc(num_islands, sizeof(Link));
+    int connected = 0;
+    for (; connected < num_islands; connected++) {
+        links[connected].fd = accept_link(listen_fd);
+        if (links[connected].fd < 0) break;
+        int one = 1;
+        setsockopt(links[connected].fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    close(listen_fd);
+    if (strncmp(address, "unix:", 5) == 0) unlink(address + 5);
+
+    for (int i = 0; i < connected; i++) {
+        uint8_t msg[FRAME_HEADER + 8];
+        Writer w = {msg, sizeof(msg), 0};
+        put_u32(&w, 1 + 8);
+        put_byte(&w, MSG_WELCOME);
+        put_u32(&w, (uint32_t)i);
+        put_u32(&w, (uint32_t)num_islands);
+        if (connected < num_islands || send_all(links[i].fd, msg, sizeof(msg)) < 0) link_close(&links[i]);
+    }
+
+    Rng rng;
+    rng_seed(&rng, 0x6d696772ULL);
+    struct pollfd* fds = calloc(num_islands, sizeof(struct pollfd));
+    for (;;) {
+        int open = 0;
+        for (int i = 0; i < num_islands; i++) {
+            fds[i].fd = links[i].fd;
+            fds[i].events = POLLIN | (links[i].out.len ? POLLOUT : 0);
+            fds[i].revents = 0;
+            if (links[i].fd >= 0) open++;
+        }
+        if (open == 0) break;
+        if (poll(fds, num_islands, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < num_islands; i++) {
+            if (links[i].fd < 0 || !fds[i].revents) continue;
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                !link_read(links, num_islands, i, topology, &rng)) {
+                link_close(&links[i]);
+            }
+        }
+        for (int i = 0; i < num_islands; i++) {
+            if (links[i].fd >= 0 && links[i].out.len && !link_write(&links[i])) link_close(&links[i]);
+        }
+    }
+
+    for (int i = 0; i < num_islands; i++) {
+        if (link_stats) link_stats[i] = links[i].stats;
+        link_close(&links[i]);
+        free(links[i].in.data);
+        free(links[i].out.data);
+    }
+    free(fds);
+    free(links);
+    return connected == num_islands ? 0 : -1;
+}
+
+// Island side
+
+struct MigrationClient {
+    int fd;
+    int island_id;
+    int num_islands;
+    Buffer in;
+    Buffer frame;               // Outgoing MIGRANTS frame under construction
+    Program** pending;          // Decoded migrants not yet taken
+    int num_pending;
+    int pending_cap;
+    MigrationLinkStats stats;
+};
+
+MigrationClient* migration_connect(const char* address) {
+    // The coordinator may still be starting: retry for a few seconds
+    int fd = -1;
+    for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+        fd = open_socket(address, 0);
+        if (fd < 0) {
+            struct timespec delay = {0, 50 * 1000000L};
+            nanosleep(&delay, NULL);
+        }
+    }
+    if (fd < 0) return NULL;
+
+    uint8_t hello[FRAME_HEADER];
+    Writer w = {hello, sizeof(hello), 0};
+    put_u32(&w, 1);
+    put_byte(&w, MSG_HELLO);
+
+    // Block until every island has connected and ours has been numbered
+    uint8_t welcome[FRAME_HEADER + 8];
+    size_t got = 0;
+    if (send_all(fd, hello, sizeof(hello)) == 0) {
+        while (got < sizeof(welcome)) {
+            ssize_t n = recv(fd, welcome + got, sizeof(welcome) - got, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            got += n;
+        }
+    }
+    Reader r = {welcome, got, 0, 0, 0};
+    uint32_t len = get_u32(&r);
+    uint8_t type = get_byte(&r);
+    uint32_t id = get_u32(&r);
+    uint32_t count = get_u32(&r);
+    if (r.error || len != 1 + 8 || type != MSG_WELCOME) {
+        close(fd);
+        return NULL;
+    }
+
+    MigrationClient* client = calloc(1, sizeof(MigrationClient));
+    client->fd = fd;
+    client->island_id = (int)id;
+    client->num_islands = (int)count;
+    return client;
+}
+
+void migration_close(MigrationClient* client) {
+    if (!client) return;
+    close(client->fd);
+    for (int i = 0; i < client->num_pending; i++) prog_destroy(client->pending[i]);
+    free(client->pending);
+    free(client->in.data);
+    free(client->frame.data);
+    free(client);
+}
+
+int migration_island_id(MigrationClient* client) {
+    return client->island_id;
+}
+
+int migration_num_islands(MigrationClient* client) {
+    return client->num_islands;
+}
+
+void migration_stats(MigrationClient* client, MigrationLinkStats* stats) {
+    *stats = client->stats;
+}
+
+int migration_send(MigrationClient* client, Program** progs, int count, Population* pop) {
+    Buffer* b = &client->frame;
+    b->len = MIGRANTS_HEADER;
+    buffer_reserve(b, 0);
+
+    for (int i = 0; i < count; i++) {
+        Program tmp = *progs[i];
+        if (pop) tmp.root = node_inline_library(progs[i]->root, pop);
+        size_t need = prog_serialize(&tmp, NULL, 0);
+        buffer_reserve(b, need);
+        b->len += prog_serialize(&tmp, b->data + b->len, need);
+        if (pop) node_destroy(tmp.root);
+    }
+
+    Writer w = {b->data, MIGRANTS_HEADER, 0};
+    put_u32(&w, (uint32_t)(b->len - 4));
+    put_byte(&w, MSG_MIGRANTS);
+    put_u64(&w, wall_ns());
+    put_u32(&w, (uint32_t)client->island_id);
+    put_u32(&w, (uint32_t)count);
+
+    if (send_all(client->fd, b->data, b->len) < 0) return -1;
+    client->stats.bytes_sent += b->len;
+    client->stats.frames_sent++;
+    client->stats.migrants_sent += count;
+    return 0;
+}
+
+static void decode_migrants(MigrationClient* client, const uint8_t* frame, size_t len) {
+    Reader r = {frame, len, FRAME_HEADER, 0, 0};
+    uint64_t sent_ns = get_u64(&r);
+    get_u32(&r);
+    uint32_t count = get_u32(&r);
+    if (r.error) return;
+
+    client->stats.bytes_received += len;
+    client->stats.frames_received++;
+    record_latency(&client->stats, sent_ns);
+
+    size_t pos = r.pos;
+    for (uint32_t i = 0; i < count && pos < len; i++) {
+        size_t used;
+        Program* prog = prog_deserialize(frame + pos, len - pos, &used);
+        if (!prog) break;  // Malformed: drop the rest of the frame
+        pos += used;
+        if (client->num_pending == client->pending_cap) {
+            client->pending_cap = client->pending_cap ? client->pending_cap * 2 : 16;
+            client->pending = realloc(client->pending, sizeof(Program*) * client->pending_cap);
+        }
+        client->pending[client->num_pending++] = prog;
+        client->stats.migrants_received++;
+    }
+}
+
+int migration_receive(MigrationClient* client, Program** out, int max) {
+    if (!buffer_fill(&client->in, client->fd) && client->in.len == 0 && client->num_pending == 0) {
+        return -1;  // Coordinator gone
+    }
+    long len;
+    while ((len = buffer_frame(&client->in)) > 0) {
+        if (client->in.data[4] == MSG_MIGRANTS && len >= MIGRANTS_HEADER) {
+            decode_migrants(client, client->in.data, len);
+        }
+        buffer_consume(&client->in, len);
+    }
+    if (len < 0) client->in.len = 0;
+
+    int n = client->num_pending < max ? client->num_pending : max;
+    if (n <= 0) return 0;
+    memcpy(out, client->pending, sizeof(Program*) * n);
+    memmove(client->pending, client->pending + n, sizeof(Program*) * (client->num_pending - n));
+    client->num_pending -= n;
+    return n;
+}
+
+// Swap arrived migrants in for the last (non-elite) programs, then send
+// copies of this island's elites. Call between generations.
+int migration_exchange(MigrationClient* client, Population* pop, int num_migrants) {
+    if (!pop->programs[0]) return 0;  // Not initialized yet
+
+    int slots = pop->pop_size - pop->elite_size;
+    Program** arrived = malloc(sizeof(Program*) * (slots > 0 ? slots : 1));
+    int n = migration_receive(client, arrived, slots);
+    for (int i = 0; i < n; i++) {
+        int slot = pop->pop_size - 1 - i;
+        prog_destroy(pop->programs[slot]);
+        pop->programs[slot] = arrived[i];
+    }
+    free(arrived);
+
+    int count = num_migrants < pop->elite_size ? num_migrants : pop->elite_size;
+    if (count <= 0 || client->num_islands < 2) return n < 0 ? -1 : 0;
+    if (migration_send(client, pop->programs, count, pop) < 0) return -1;
+    return n < 0 ? -1 : 0;
+}
@@ -0,0 +1,132 @@
+#include "gp.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Hardware performance counters
+//
+// One perf_event_open counter per event on the calling thread, user space
+// only, opened as a single group led by the first event that opens. A
+// missing event (no PMU in a VM or container, an event the CPU doesn't have,
+// perf_event_paranoid) only drops that event. The group is scheduled as a
+// unit, so when the kernel multiplexes it every count is scaled by the same
+// enabled/running ratio and the ratios between events stay meaningful.
+
+const char* gp_perf_names[PERF_COUNT] = {
+    "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses",
+};
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct PerfCounters {
+    int fd[PERF_COUNT];         // -1 = unavailable
+    int slot[PERF_COUNT];       // Position of the event in a group read
+    int leader;                 // Group leader's fd, -1 = no events
+};
+
+static void perf_attr(struct perf_event_attr* attr, int event) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                        PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+        case PERF_CYCLES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PERF_L1D_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_L1D |
+                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+    }
+}
+
+PerfCounters* perf_open(void) {
+    PerfCounters* pc = malloc(sizeof(PerfCounters));
+    pc->leader = -1;
+    int members = 0;
+    for (int e = 0; e < PERF_COUNT; e++) {
+        struct perf_event_attr attr;
+        perf_attr(&attr, e);
+        pc->fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, pc->leader, 0);
+        if (pc->fd[e] < 0) continue;
+        if (pc->leader < 0) pc->leader = pc->fd[e];
+        pc->slot[e] = members++;
+    }
+    return pc;
+}
+
+void perf_close(PerfCounters* pc) {
+    if (!pc) return;
+    for (int e = 0; e < PERF_COUNT; e++) {
+        if (pc->fd[e] >= 0) close(pc->fd[e]);
+    }
+    free(pc);
+}
+
+unsigned perf_available(PerfCounters* pc) {
+    unsigned mask = 0;
+    for (int e = 0; pc && e < PERF_COUNT; e++) {
+        if (pc->fd[e] >= 0) mask |= 1u << e;
+    }
+    return mask;
+}
+
+void perf_read(PerfCounters* pc, uint64_t values[PERF_COUNT]) {
+    memset(values, 0, sizeof(uint64_t) * PERF_COUNT);
+    if (!pc || pc->leader < 0) return;
+    uint64_t buf[3 + PERF_COUNT];   // nr, time enabled, time running, one value per member
+    ssize_t got = read(pc->leader, buf, sizeof(buf));
+    if (got < (ssize_t)(3 * sizeof(uint64_t)) || buf[2] == 0) return;
+    uint64_t nr = buf[0];
+    double scale = buf[2] < buf[1] ? (double)buf[1] / buf[2] : 1.0;
+    for (int e = 0; e < PERF_COUNT; e++) {
+        if (pc->fd[e] < 0 || (uint64_t)pc->slot[e] >= nr) continue;
+        values[e] = scale == 1.0 ? buf[3 + pc->slot[e]] : (uint64_t)(buf[3 + pc->slot[e]] * scale);
+    }
+}
+
+#else
+
+struct PerfCounters {
+    int unused;
+};
+
+PerfCounters* perf_open(void) {
+    return calloc(1, sizeof(PerfCounters));
+}
+
+void perf_close(PerfCounters* pc) {
+    free(pc);
+}
+
+unsigned perf_available(PerfCounters* pc) {
+    (void)pc;
+    return 0;
+}
+
+void perf_read(PerfCounters* pc, uint64_t values[PERF_COUNT]) {
+    (void)pc;
+    memset(values, 0, sizeof(uint64_t) * PERF_COUNT);
+}
+
+#endif
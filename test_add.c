@@ -1,32 +1,31 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
 
 // Fitness function for a+b task
-float evaluate_add(Program* prog, void* data) {
+float evaluate_add(Program* prog, void* data, Rng* rng) {
     (void)data;  // Unused
 
     float total_error = 0.0f;
     int test_cases = 10;
 
+    // All cases run in one batched (SIMD) pass
+    BatchContext* batch = batch_create(test_cases, 2);
     for (int i = 0; i < test_cases; i++) {
-        int a = rand() % 20;
-        int b = rand() % 20;
-        int expected = a + b;
-
-        Context ctx = {0};
-        ctx.inputs[0] = a;
-        ctx.inputs[1] = b;
-        ctx.num_inputs = 2;
+        batch->inputs[0][i] = rng_int(rng, 20);
+        batch->inputs[1][i] = rng_int(rng, 20);
+    }
 
-        execute_program(prog, &ctx, NULL);
+    execute_program_batch(prog, batch, NULL);
 
-        int result = (ctx.num_outputs > 0) ? ctx.outputs[0] : 0;
+    for (int i = 0; i < test_cases; i++) {
+        int expected = batch->inputs[0][i] + batch->inputs[1][i];
+        int result = (batch->num_outputs[i] > 0) ? batch->outputs[0][i] : 0;
         int error = abs(result - expected);
         total_error += error;
     }
+    batch_destroy(batch);
 
     float avg_error = total_error / test_cases;
     float fitness = 100.0f - avg_error;
@@ -39,14 +38,13 @@ float evaluate_add(Program* prog, void* data) {
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("Tree-based GP - Simple Add Test\n");
     printf("================================\n\n");
     printf("Task: Learn to output a + b given inputs [a, b]\n");
     printf("Population: %d, Tournament: %d, Elite: %d\n\n", POP_SIZE, TOURNAMENT_SIZE, ELITE_SIZE);
 
     Population* pop = pop_create();
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 1000;
     int no_improvement = 0;
@@ -81,8 +79,8 @@ int main() {
             printf("\nTesting on 20 new cases:\n");
             int correct = 0;
             for (int i = 0; i < 20; i++) {
-                int a = rand() % 20;
-                int b = rand() % 20;
+                int a = rng_int(gp_rng(), 20);
+                int b = rng_int(gp_rng(), 20);
                 int expected = a + b;
 
                 Context ctx = {0};
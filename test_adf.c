@@ -1,41 +1,39 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 // Simple fitness: compute a + b using evolved ADF
-float evaluate_add_adf(Program* prog, void* data) {
+float evaluate_add_adf(Program* prog, void* data, Rng* rng) {
     (void)data;
 
     int correct = 0;
     int total = 20;
 
+    BatchContext* batch = batch_create(total, 2);
     for (int i = 0; i < total; i++) {
-        int a = rand() % 20 - 10;
-        int b = rand() % 20 - 10;
-
-        Context ctx = {0};
-        ctx.inputs[0] = a;
-        ctx.inputs[1] = b;
-        ctx.num_inputs = 2;
+        batch->inputs[0][i] = rng_int(rng, 20) - 10;
+        batch->inputs[1][i] = rng_int(rng, 20) - 10;
+    }
 
-        execute_program(prog, &ctx, NULL);
+    execute_program_batch(prog, batch, NULL);
 
-        if (ctx.num_outputs > 0 && ctx.outputs[0] == a + b) {
+    for (int i = 0; i < total; i++) {
+        int sum = batch->inputs[0][i] + batch->inputs[1][i];
+        if (batch->num_outputs[i] > 0 && batch->outputs[0][i] == sum) {
             correct++;
         }
     }
+    batch_destroy(batch);
 
     return (float)correct;
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("ADF Test - Learning Addition\n");
     printf("==============================\n\n");
 
     Population* pop = pop_create();
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     // Run evolution
     for (int gen = 0; gen < 50; gen++) {
@@ -1,7 +1,7 @@
 #include "gp.h"
+#include "cartpole.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
 
 // CartPole physics constants
@@ -44,7 +44,7 @@ int cartpole_is_failed(CartPoleState* state) {
 }
 
 // Fitness function for CartPole
-float evaluate_cartpole(Program* prog, void* data) {
+float evaluate_cartpole(Program* prog, void* data, Rng* rng) {
     (void)data;
 
     int num_episodes = 10;  // More episodes for more accurate fitness
@@ -52,9 +52,9 @@ float evaluate_cartpole(Program* prog, void* data) {
 
     for (int ep = 0; ep < num_episodes; ep++) {
         CartPoleState state = {
-            .x = ((float)rand() / RAND_MAX - 0.5f) * 0.1f,
+            .x = (rng_float(rng) - 0.5f) * 0.1f,
             .x_dot = 0.0f,
-            .theta = ((float)rand() / RAND_MAX - 0.5f) * 0.1f,
+            .theta = (rng_float(rng) - 0.5f) * 0.1f,
             .theta_dot = 0.0f
         };
 
@@ -94,8 +94,6 @@ float evaluate_cartpole(Program* prog, void* data) {
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("Tree-based GP - CartPole Test\n");
     printf("==============================\n\n");
     printf("Task: Learn to balance pole on cart\n");
@@ -104,7 +102,12 @@ int main() {
     printf("Success: Balance for 500 steps\n");
     printf("Population: %d, Tournament: %d, Elite: %d\n\n", POP_SIZE, TOURNAMENT_SIZE, ELITE_SIZE);
 
-    Population* pop = pop_create();
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.input_ranges = cartpole_input_ranges;   // Used with GP_SIMPLIFY
+    cfg.num_input_ranges = 4;
+    Population* pop = pop_create_config(&cfg);
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 5000;
     int no_improvement = 0;
@@ -144,9 +147,9 @@ int main() {
 
             for (int i = 0; i < 20; i++) {
                 CartPoleState state = {
-                    .x = ((float)rand() / RAND_MAX - 0.5f) * 0.1f,
+                    .x = (rng_float(gp_rng()) - 0.5f) * 0.1f,
                     .x_dot = 0.0f,
-                    .theta = ((float)rand() / RAND_MAX - 0.5f) * 0.1f,
+                    .theta = (rng_float(gp_rng()) - 0.5f) * 0.1f,
                     .theta_dot = 0.0f
                 };
 
@@ -0,0 +1,121 @@
+#include "gp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Migrants leave their island with library calls inlined, because the
+// island or process they reach has a different library (see
+// node_inline_library). This evolves populations on several tasks and
+// checks that every program comes out of inlining free of calls, and that
+// run without a library it does what it did with one.
+
+// Task fitness functions, linked in from the test programs (see Makefile)
+float evaluate_cartpole(Program* prog, void* data, Rng* rng);
+float evaluate_maze(Program* prog, void* data, Rng* rng);
+float evaluate_mux(Program* prog, void* data, Rng* rng);
+float evaluate_taxi(Program* prog, void* data, Rng* rng);
+
+#define GENERATIONS 60
+#define POP 500
+#define STEPS 3     // Runs per program, with memory carried over
+
+typedef struct {
+    const char* name;
+    FitnessFn fitness;
+    int num_inputs;
+} Task;
+
+static const Task tasks[] = {
+    {"cartpole", evaluate_cartpole, 4},
+    {"maze", evaluate_maze, 4},
+    {"mux", evaluate_mux, 11},
+    {"taxi", evaluate_taxi, 8},
+};
+
+static int count_calls(Node* node) {
+    if (!node) return 0;
+    int calls = node->op == OP_LIBRARY || node->op == OP_FUNC_CALL;
+    for (int i = 0; i < node->num_children; i++) calls += count_calls(node->children[i]);
+    return calls;
+}
+
+// Memory cells a program can touch, through the library entries it calls
+static void reachable_cells(Node* node, Population* pop, unsigned* cells, int* visited) {
+    if (!node) return;
+    if ((node->op == OP_MEM_READ || node->op == OP_MEM_WRITE) && node->value >= 0 &&
+        node->value < MAX_MEMORY) {
+        *cells |= 1u << node->value;
+    }
+    if ((node->op == OP_LIBRARY || node->op == OP_FUNC_CALL) && node->value >= 0 &&
+        node->value < pop->library_size && !visited[node->value]) {
+        visited[node->value] = 1;
+        reachable_cells(pop->library[node->value].tree, pop, cells, visited);
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        reachable_cells(node->children[i], pop, cells, visited);
+    }
+}
+
+// Run a program and its inlined copy side by side. Cells only the copy
+// touches hold its argument bindings and are not compared.
+static int same_behaviour(Node* root, Node* inlined, Population* pop, int num_inputs, Rng* rng) {
+    unsigned cells = 0;
+    int visited[MAX_LIBRARY] = {0};
+    reachable_cells(root, pop, &cells, visited);
+
+    Context a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    a.num_inputs = b.num_inputs = num_inputs;
+    for (int step = 0; step < STEPS; step++) {
+        for (int i = 0; i < num_inputs; i++) a.inputs[i] = b.inputs[i] = rng_int(rng, 200) - 100;
+        a.num_outputs = b.num_outputs = 0;
+        if (execute_node(root, &a, pop) != execute_node(inlined, &b, NULL)) return 0;
+        if (a.num_outputs != b.num_outputs) return 0;
+        if (memcmp(a.outputs, b.outputs, a.num_outputs * sizeof(int)) != 0) return 0;
+        for (int k = 0; k < MAX_MEMORY; k++) {
+            if ((cells & (1u << k)) && a.memory[k] != b.memory[k]) return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    int failures = 0;
+    printf("Library inlining for migrants\n");
+    printf("=============================\n\n");
+
+    for (int t = 0; t < (int)(sizeof(tasks) / sizeof(tasks[0])); t++) {
+        PopConfig cfg;
+        pop_config_default(&cfg);
+        cfg.seed = 1;
+        cfg.pop_size = POP;
+        cfg.stats_json = NULL;
+        Population* pop = pop_create_config(&cfg);
+        Rng rng;
+        rng_seed(&rng, 1);
+
+        int with_calls = 0, kept = 0, differ = 0;
+        for (int g = 0; g < GENERATIONS; g++) {
+            evolve_generation(pop, tasks[t].fitness, NULL, tasks[t].num_inputs);
+            for (int i = 0; i < pop->pop_size; i++) {
+                Node* root = pop->programs[i]->root;
+                if (!count_calls(root)) continue;
+                with_calls++;
+                Node* inlined = node_inline_library(root, pop);
+                if (count_calls(inlined)) kept++;
+                else if (!same_behaviour(root, inlined, pop, tasks[t].num_inputs, &rng)) differ++;
+                node_destroy(inlined);
+            }
+        }
+        pop_destroy(pop);
+
+        int ok = with_calls > 0 && kept == 0 && differ == 0;
+        printf("%-10s %5d programs with calls, %d still calling, %d behaving differently  %s\n",
+               tasks[t].name, with_calls, kept, differ, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+    }
+
+    printf("\n%s\n", failures ? "FAILED" : "All tasks passed");
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,6 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <string.h>
 #include <math.h>
 
@@ -91,8 +90,9 @@ void maze_print(MazeState* state) {
     }
 }
 
-float evaluate_maze(Program* prog, void* data) {
+float evaluate_maze(Program* prog, void* data, Rng* rng) {
     (void)data;
+    (void)rng;
 
     int num_episodes = 10;
     float total_reward = 0;
@@ -158,8 +158,6 @@ float evaluate_maze(Program* prog, void* data) {
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("Tree-based GP - Maze Navigation\n");
     printf("================================\n\n");
 
@@ -173,7 +171,12 @@ int main() {
     printf("Output: action (0=N, 1=S, 2=E, 3=W)\n");
     printf("Population: %d\n\n", POP_SIZE);
 
-    Population* pop = pop_create();
+    // Fitness doesn't depend on the Rng, so cached results stay valid
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.deterministic_fitness = 1;
+    Population* pop = pop_create_config(&cfg);
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 3000;
     float best_ever = -INFINITY;
@@ -1,7 +1,7 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include <math.h>
 
 // 11-bit multiplexer:
@@ -9,8 +9,9 @@
 // Output: data bit at address (a2*4 + a1*2 + a0)
 // Much harder than 6-bit version!
 
-float evaluate_mux(Program* prog, void* data) {
+float evaluate_mux(Program* prog, void* data, Rng* rng) {
     (void)data;
+    (void)rng;
 
     // Track correctness per address value (8 addresses)
     int correct_per_address[8] = {0};
@@ -18,57 +19,83 @@ float evaluate_mux(Program* prog, void* data) {
 
     int total = 2048;  // All 2^11 possible inputs
 
-    for (int test = 0; test < total; test++) {
-        // Extract bits from test case
-        int a0 = (test >> 0) & 1;
-        int a1 = (test >> 1) & 1;
-        int a2 = (test >> 2) & 1;
-        int d0 = (test >> 3) & 1;
-        int d1 = (test >> 4) & 1;
-        int d2 = (test >> 5) & 1;
-        int d3 = (test >> 6) & 1;
-        int d4 = (test >> 7) & 1;
-        int d5 = (test >> 8) & 1;
-        int d6 = (test >> 9) & 1;
-        int d7 = (test >> 10) & 1;
-
-        // Calculate expected output
-        int address = a2 * 4 + a1 * 2 + a0;
-        int expected;
-        switch(address) {
-            case 0: expected = d0; break;
-            case 1: expected = d1; break;
-            case 2: expected = d2; break;
-            case 3: expected = d3; break;
-            case 4: expected = d4; break;
-            case 5: expected = d5; break;
-            case 6: expected = d6; break;
-            case 7: expected = d7; break;
-            default: expected = 0;
+    if (prog_is_bitsliceable(prog, NULL)) {
+        // Boolean program: 64 cases per evaluation, scored by popcount
+        for (int word = 0; word < total / BITSLICE_LANES; word++) {
+            BitContext bctx;
+            bitslice_truth_table(&bctx, 11, word);
+            execute_program_bits(prog, &bctx, NULL);
+
+            uint64_t* in = bctx.inputs;
+            uint64_t result = bctx.outputs[0] & bctx.has_output[0];
+            uint64_t selected[8];
+            uint64_t expected = 0;
+            for (int addr = 0; addr < 8; addr++) {
+                selected[addr] = ((addr & 1) ? in[0] : ~in[0]) &
+                                 ((addr & 2) ? in[1] : ~in[1]) &
+                                 ((addr & 4) ? in[2] : ~in[2]);
+                expected |= selected[addr] & in[3 + addr];
+            }
+
+            uint64_t correct = ~(result ^ expected);
+            for (int addr = 0; addr < 8; addr++) {
+                total_per_address[addr] += __builtin_popcountll(selected[addr]);
+                correct_per_address[addr] += __builtin_popcountll(correct & selected[addr]);
+            }
         }
+    } else {
+        for (int test = 0; test < total; test++) {
+            // Extract bits from test case
+            int a0 = (test >> 0) & 1;
+            int a1 = (test >> 1) & 1;
+            int a2 = (test >> 2) & 1;
+            int d0 = (test >> 3) & 1;
+            int d1 = (test >> 4) & 1;
+            int d2 = (test >> 5) & 1;
+            int d3 = (test >> 6) & 1;
+            int d4 = (test >> 7) & 1;
+            int d5 = (test >> 8) & 1;
+            int d6 = (test >> 9) & 1;
+            int d7 = (test >> 10) & 1;
+
+            // Calculate expected output
+            int address = a2 * 4 + a1 * 2 + a0;
+            int expected;
+            switch(address) {
+                case 0: expected = d0; break;
+                case 1: expected = d1; break;
+                case 2: expected = d2; break;
+                case 3: expected = d3; break;
+                case 4: expected = d4; break;
+                case 5: expected = d5; break;
+                case 6: expected = d6; break;
+                case 7: expected = d7; break;
+                default: expected = 0;
+            }
+
+            // Run program
+            Context ctx = {0};
+            ctx.inputs[0] = a0;
+            ctx.inputs[1] = a1;
+            ctx.inputs[2] = a2;
+            ctx.inputs[3] = d0;
+            ctx.inputs[4] = d1;
+            ctx.inputs[5] = d2;
+            ctx.inputs[6] = d3;
+            ctx.inputs[7] = d4;
+            ctx.inputs[8] = d5;
+            ctx.inputs[9] = d6;
+            ctx.inputs[10] = d7;
+            ctx.num_inputs = 11;
+
+            execute_program(prog, &ctx, NULL);
 
-        // Run program
-        Context ctx = {0};
-        ctx.inputs[0] = a0;
-        ctx.inputs[1] = a1;
-        ctx.inputs[2] = a2;
-        ctx.inputs[3] = d0;
-        ctx.inputs[4] = d1;
-        ctx.inputs[5] = d2;
-        ctx.inputs[6] = d3;
-        ctx.inputs[7] = d4;
-        ctx.inputs[8] = d5;
-        ctx.inputs[9] = d6;
-        ctx.inputs[10] = d7;
-        ctx.num_inputs = 11;
-
-        execute_program(prog, &ctx, NULL);
-
-        int result = (ctx.num_outputs > 0) ? (ctx.outputs[0] & 1) : 0;
-
-        total_per_address[address]++;
-        if (result == expected) {
-            correct_per_address[address]++;
+            int result = (ctx.num_outputs > 0) ? (ctx.outputs[0] & 1) : 0;
+
+            total_per_address[address]++;
+            if (result == expected) {
+                correct_per_address[address]++;
+            }
         }
     }
 
@@ -90,8 +117,13 @@ float evaluate_mux(Program* prog, void* data) {
     return fitness;
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char** argv) {
+    int num_islands = 0;
+    int boolean = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--islands") == 0 && i + 1 < argc) num_islands = atoi(argv[++i]);
+        if (strcmp(argv[i], "--boolean") == 0) boolean = 1;
+    }
 
     printf("11-bit Multiplexer Problem\n");
     printf("==========================\n\n");
@@ -100,20 +132,55 @@ int main() {
     printf("Test cases: 2048 (all possible inputs)\n");
     printf("Population: %d\n\n", POP_SIZE);
 
-    Population* pop = pop_create();
+    // Fitness doesn't depend on the Rng, so cached results stay valid
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.deterministic_fitness = 1;
+    // Every input is a bit (used with GP_SIMPLIFY to prune dead branches)
+    ValueRange bits[11];
+    for (int i = 0; i < 11; i++) bits[i] = (ValueRange){0, 1};
+    cfg.input_ranges = bits;
+    cfg.num_input_ranges = 11;
+    // --boolean: only ops and constants the bit-sliced path runs, so every
+    // program is scored 64 cases at a time
+    cfg.boolean_ops = boolean;
+
+    // --islands N: N independent subpopulations exchanging elites; pop then
+    // follows whichever island is currently best
+    IslandModel* islands = NULL;
+    Population* pop;
+    if (num_islands > 0) {
+        IslandConfig icfg;
+        island_config_default(&icfg);
+        icfg.num_islands = num_islands;
+        icfg.target_fitness = 2000.0f;
+        icfg.pop = cfg;
+        islands = island_create(&icfg);
+        pop = island_population(islands, 0);
+        printf("Islands: %d\n", island_count(islands));
+    } else {
+        pop = pop_create_config(&cfg);
+    }
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 5000;
     float best_ever = -INFINITY;
     int no_improvement = 0;
 
-    for (int gen = 0; gen < max_gen; gen++) {
-        evolve_generation(pop, evaluate_mux, NULL, 11);
+    int step = islands ? 10 : 1;
+    for (int gen = 0; gen < max_gen; gen += step) {
+        if (islands) {
+            island_evolve(islands, evaluate_mux, NULL, 11, step);
+            pop = island_population(islands, island_best_index(islands));
+        } else {
+            evolve_generation(pop, evaluate_mux, NULL, 11);
+        }
 
         if (pop->best_fitness > best_ever) {
             best_ever = pop->best_fitness;
             no_improvement = 0;
         } else {
-            no_improvement++;
+            no_improvement += step;
         }
 
         if (gen % 10 == 0 || pop->best_fitness >= 2000.0f) {
@@ -223,6 +290,10 @@ int main() {
         print_tree(pop->best->root, 0);
     }
 
-    pop_destroy(pop);
+    if (islands) {
+        island_destroy(islands);
+    } else {
+        pop_destroy(pop);
+    }
     return 0;
 }
@@ -1,39 +1,51 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include <math.h>
 
 // 3-bit even parity:
 // Output 1 if even number of 1s in input (including 0)
 // Output 0 if odd number of 1s
 
-float evaluate_parity(Program* prog, void* data) {
+float evaluate_parity(Program* prog, void* data, Rng* rng) {
     (void)data;
+    (void)rng;
 
     int correct = 0;
     int total = 8;  // 2^3 = 8 test cases
 
-    for (int test = 0; test < total; test++) {
-        int b0 = (test >> 0) & 1;
-        int b1 = (test >> 1) & 1;
-        int b2 = (test >> 2) & 1;
+    if (prog_is_bitsliceable(prog, NULL)) {
+        // Boolean program: all 8 cases in one evaluation
+        BitContext bctx;
+        bitslice_truth_table(&bctx, 3, 0);
+        execute_program_bits(prog, &bctx, NULL);
 
-        // Even parity: XOR of all bits
-        int expected = (b0 ^ b1 ^ b2) == 0 ? 1 : 0;
+        uint64_t result = bctx.outputs[0] & bctx.has_output[0];
+        uint64_t expected = ~(bctx.inputs[0] ^ bctx.inputs[1] ^ bctx.inputs[2]);
+        correct = __builtin_popcountll(~(result ^ expected) & bctx.lanes);
+    } else {
+        for (int test = 0; test < total; test++) {
+            int b0 = (test >> 0) & 1;
+            int b1 = (test >> 1) & 1;
+            int b2 = (test >> 2) & 1;
 
-        Context ctx = {0};
-        ctx.inputs[0] = b0;
-        ctx.inputs[1] = b1;
-        ctx.inputs[2] = b2;
-        ctx.num_inputs = 3;
+            // Even parity: XOR of all bits
+            int expected = (b0 ^ b1 ^ b2) == 0 ? 1 : 0;
 
-        execute_program(prog, &ctx, NULL);
+            Context ctx = {0};
+            ctx.inputs[0] = b0;
+            ctx.inputs[1] = b1;
+            ctx.inputs[2] = b2;
+            ctx.num_inputs = 3;
 
-        int result = (ctx.num_outputs > 0) ? (ctx.outputs[0] & 1) : 0;
+            execute_program(prog, &ctx, NULL);
 
-        if (result == expected) {
-            correct++;
+            int result = (ctx.num_outputs > 0) ? (ctx.outputs[0] & 1) : 0;
+
+            if (result == expected) {
+                correct++;
+            }
         }
     }
 
@@ -43,8 +55,11 @@ float evaluate_parity(Program* prog, void* data) {
     return fitness;
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char** argv) {
+    int boolean = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--boolean") == 0) boolean = 1;
+    }
 
     printf("3-bit Even Parity Problem\n");
     printf("=========================\n\n");
@@ -53,7 +68,19 @@ int main() {
     printf("Test cases: 8 (all possible inputs)\n");
     printf("Population: %d\n\n", POP_SIZE);
 
-    Population* pop = pop_create();
+    // Fitness doesn't depend on the Rng, so cached results stay valid
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.deterministic_fitness = 1;
+    // Every input is a bit (used with GP_SIMPLIFY to prune dead branches)
+    static const ValueRange bits[3] = {{0, 1}, {0, 1}, {0, 1}};
+    cfg.input_ranges = bits;
+    cfg.num_input_ranges = 3;
+    // --boolean: only ops and constants the bit-sliced path runs, so every
+    // program is scored in one pass
+    cfg.boolean_ops = boolean;
+    Population* pop = pop_create_config(&cfg);
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 500;
     float best_ever = -INFINITY;
@@ -1,7 +1,6 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
 
 // Test: accumulate sequence
@@ -9,37 +8,40 @@
 // Example: inputs [3, 5, 2] -> outputs [3, 8, 10]
 // Requires memory to track sum so far
 
-float evaluate_sequence(Program* prog, void* data) {
+float evaluate_sequence(Program* prog, void* data, Rng* rng) {
     (void)data;
 
     float total_error = 0.0f;
     int num_tests = 10;
 
+    // The tests run side by side as batch lanes; memory persists per lane
+    // across the 5 steps just like a reused Context
+    BatchContext* batch = batch_create(num_tests, 1);
+    int sequence[10][5];
+    int running_sum[10] = {0};
     for (int test = 0; test < num_tests; test++) {
-        Context ctx = {0};  // Zero-initialize including memory
-
-        // Generate random sequence of 5 numbers
-        int sequence[5];
         for (int i = 0; i < 5; i++) {
-            sequence[i] = rand() % 10;
+            sequence[test][i] = rng_int(rng, 10);
         }
+    }
 
-        // Run program on each number, expect running sum
-        int running_sum = 0;
-        for (int i = 0; i < 5; i++) {
-            ctx.inputs[0] = sequence[i];
-            ctx.num_inputs = 1;
-            ctx.num_outputs = 0;  // Reset outputs
+    // Run program on each number, expect running sum
+    for (int i = 0; i < 5; i++) {
+        for (int test = 0; test < num_tests; test++) {
+            batch->inputs[0][test] = sequence[test][i];
+        }
 
-            execute_program(prog, &ctx, NULL);
+        execute_program_batch(prog, batch, NULL);
 
-            running_sum += sequence[i];
-            int expected = running_sum;
-            int result = (ctx.num_outputs > 0) ? ctx.outputs[0] : 0;
+        for (int test = 0; test < num_tests; test++) {
+            running_sum[test] += sequence[test][i];
+            int expected = running_sum[test];
+            int result = (batch->num_outputs[test] > 0) ? batch->outputs[0][test] : 0;
             int error = abs(result - expected);
             total_error += error;
         }
     }
+    batch_destroy(batch);
 
     float avg_error = total_error / (num_tests * 5);
     float fitness = 100.0f - avg_error;
@@ -48,8 +50,6 @@ float evaluate_sequence(Program* prog, void* data) {
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("Tree-based GP - Sequence Accumulation Test\n");
     printf("==========================================\n\n");
     printf("Task: Output running sum of inputs\n");
@@ -57,6 +57,7 @@ int main() {
     printf("Requires memory to track sum\n\n");
 
     Population* pop = pop_create();
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 2000;
     float best_ever = -INFINITY;
@@ -0,0 +1,121 @@
+#include "gp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Round trips through prog_serialize / prog_deserialize: random trees with
+// missing children, large values and variable-arity calls, then programs
+// from an evolved population. Every truncation of an encoding must be
+// rejected rather than decoded.
+
+#define RANDOM_TREES 20000
+#define TREE_DEPTH 6
+#define BUF_SIZE 65536
+
+static float evaluate_sum(Program* prog, void* data, Rng* rng) {
+    (void)data;
+    float error = 0;
+    for (int i = 0; i < 5; i++) {
+        Context ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.num_inputs = 2;
+        ctx.inputs[0] = rng_int(rng, 20);
+        ctx.inputs[1] = rng_int(rng, 20);
+        execute_program(prog, &ctx, NULL);
+        int out = ctx.num_outputs > 0 ? ctx.outputs[0] : 0;
+        error += abs(out - (ctx.inputs[0] + ctx.inputs[1]));
+    }
+    return -error;
+}
+
+static int random_value(Rng* rng) {
+    switch (rng_int(rng, 4)) {
+        case 0: return 0;
+        case 1: return rng_int(rng, 20) - 10;
+        case 2: return (int)rng_next(rng);                  // Any int, including INT_MIN
+        default: return rng_int(rng, 2) ? 0x7fffffff : -0x7fffffff - 1;
+    }
+}
+
+// Every op, any value, and about one child in five missing (all of them
+// at the depth limit)
+static Node* random_tree(Rng* rng, int depth) {
+    OpType op = (OpType)rng_int(rng, OP_COUNT);
+    Node* node = node_create(op, random_value(rng));
+    if (op == OP_FUNC_CALL) node->num_children = rng_int(rng, MAX_CHILDREN + 1);
+    for (int i = 0; i < node->num_children; i++) {
+        int leave_out = depth >= TREE_DEPTH || rng_int(rng, 5) == 0;
+        node->children[i] = leave_out ? NULL : random_tree(rng, depth + 1);
+    }
+    return node;
+}
+
+static int same_tree(Node* a, Node* b) {
+    if (!a || !b) return a == b;
+    if (a->op != b->op || a->value != b->value || a->num_children != b->num_children) return 0;
+    for (int i = 0; i < a->num_children; i++) {
+        if (!same_tree(a->children[i], b->children[i])) return 0;
+    }
+    return 1;
+}
+
+static uint8_t buf[BUF_SIZE];
+
+// Encode, decode and compare; then check each shorter prefix is refused
+static int round_trip(Program* prog) {
+    size_t len = prog_serialize(prog, buf, sizeof(buf));
+    if (len == 0 || len > sizeof(buf)) return 0;
+
+    size_t used = 0;
+    Program* copy = prog_deserialize(buf, len, &used);
+    int ok = copy && used == len && same_tree(prog->root, copy->root) &&
+             memcmp(&prog->fitness, &copy->fitness, sizeof(float)) == 0;
+    prog_destroy(copy);
+
+    for (size_t cut = 0; ok && cut < len; cut++) {
+        Program* partial = prog_deserialize(buf, cut, NULL);
+        if (partial) {
+            prog_destroy(partial);
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+int main(void) {
+    int failures = 0;
+    printf("Program serialization round trips\n");
+    printf("=================================\n\n");
+
+    Rng rng;
+    rng_seed(&rng, 1);
+    int missing = 0, bad = 0;
+    for (int t = 0; t < RANDOM_TREES; t++) {
+        Program prog;
+        memset(&prog, 0, sizeof(prog));
+        prog.root = random_tree(&rng, 0);
+        prog.fitness = (float)rng_int(&rng, 1000) - 500.5f;
+        for (int i = 0; i < prog.root->num_children; i++) missing += !prog.root->children[i];
+        if (!round_trip(&prog)) bad++;
+        node_destroy(prog.root);
+    }
+    printf("random trees   %5d, %d missing children at the root, %d failed  %s\n", RANDOM_TREES,
+           missing, bad, bad ? "FAIL" : "ok");
+    failures += bad > 0;
+
+    PopConfig cfg;
+    pop_config_default(&cfg);
+    cfg.seed = 1;
+    cfg.pop_size = 500;
+    cfg.stats_json = NULL;
+    Population* pop = pop_create_config(&cfg);
+    for (int g = 0; g < 10; g++) evolve_generation(pop, evaluate_sum, NULL, 2);
+    bad = 0;
+    for (int i = 0; i < pop->pop_size; i++) bad += !round_trip(pop->programs[i]);
+    pop_destroy(pop);
+    printf("evolved        %5d programs, %d failed  %s\n", cfg.pop_size, bad, bad ? "FAIL" : "ok");
+    failures += bad > 0;
+
+    printf("\n%s\n", failures ? "FAILED" : "All checks passed");
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,6 @@
 #include "gp.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
 
 // Taxi-v3 environment
@@ -26,12 +25,12 @@ typedef struct {
     int dest_loc;   // 0-3
 } TaxiState;
 
-void taxi_reset(TaxiState* state) {
-    state->taxi_row = rand() % TAXI_SIZE;
-    state->taxi_col = rand() % TAXI_SIZE;
-    state->pass_loc = rand() % 4;  // Passenger at one of 4 locations
+void taxi_reset(TaxiState* state, Rng* rng) {
+    state->taxi_row = rng_int(rng, TAXI_SIZE);
+    state->taxi_col = rng_int(rng, TAXI_SIZE);
+    state->pass_loc = rng_int(rng, 4);  // Passenger at one of 4 locations
     do {
-        state->dest_loc = rand() % 4;
+        state->dest_loc = rng_int(rng, 4);
     } while (state->dest_loc == state->pass_loc);  // Different from pickup
 }
 
@@ -98,7 +97,7 @@ int taxi_step(TaxiState* state, int action, int* reward) {
     return 0;
 }
 
-float evaluate_taxi(Program* prog, void* data) {
+float evaluate_taxi(Program* prog, void* data, Rng* rng) {
     (void)data;
 
     int num_episodes = 10;
@@ -107,7 +106,7 @@ float evaluate_taxi(Program* prog, void* data) {
 
     for (int ep = 0; ep < num_episodes; ep++) {
         TaxiState state;
-        taxi_reset(&state);
+        taxi_reset(&state, rng);
 
         Context ctx = {0};
         int episode_reward = 0;
@@ -185,8 +184,6 @@ float evaluate_taxi(Program* prog, void* data) {
 }
 
 int main() {
-    srand(time(NULL));
-
     printf("Tree-based GP - Taxi-v3\n");
     printf("=======================\n\n");
     printf("Task: Pick up passenger and drop off at destination\n");
@@ -196,6 +193,7 @@ int main() {
     printf("Population: %d\n\n", POP_SIZE);
 
     Population* pop = pop_create();
+    printf("Seed: %llu\n\n", (unsigned long long)pop->seed);
 
     int max_gen = 2000;
     float best_ever = -INFINITY;
@@ -232,7 +230,7 @@ int main() {
             int successes = 0;
             for (int ep = 0; ep < 20; ep++) {
                 TaxiState state;
-                taxi_reset(&state);
+                taxi_reset(&state, gp_rng());
                 Context ctx = {0};
 
                 for (int step = 0; step < MAX_STEPS; step++) {